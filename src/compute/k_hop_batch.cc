@@ -0,0 +1,280 @@
+#include "k_hop_batch.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "label_filter.h"
+
+namespace {
+
+// 一批中每个查询占一位，W 个 64 位字
+template <size_t W>
+using Mask = std::array<uint64_t, W>;
+
+template <size_t W>
+inline bool any(const Mask<W>& m) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < W; ++i) {
+        acc |= m[i];
+    }
+    return acc != 0;
+}
+
+// 每顶点一个掩码的稠密数组。calloc 的大块内存按页懒清零，
+// 稀疏的批次只为实际访问到的页付出代价
+template <size_t W>
+using MaskArray = std::unique_ptr<Mask<W>[], decltype(&std::free)>;
+
+template <size_t W>
+MaskArray<W> allocMasks(size_t n) {
+    auto* data = static_cast<Mask<W>*>(std::calloc(n, sizeof(Mask<W>)));
+    if (!data)
+        throw std::bad_alloc();
+    return MaskArray<W>(data, &std::free);
+}
+
+// 所有线程、所有宽度合计缓存的掩码数组总大小上限，超出时每批各自分配、
+// 用完释放
+constexpr size_t kMaxCachedMaskBytes = size_t(256) << 20;
+
+// 一批用到的 seen / next 数组。批结束时只把访问过的顶点清零后归还共享池，
+// 下一批不必重新分配和清零整个数组
+template <size_t W>
+struct MaskBuffers {
+    MaskArray<W> seen{nullptr, &std::free};
+    MaskArray<W> next{nullptr, &std::free};
+    size_t size = 0;
+
+    void Reserve(size_t n) {
+        seen = allocMasks<W>(n);
+        next = allocMasks<W>(n);
+        size = n;
+    }
+
+    size_t Bytes() const { return 2 * size * sizeof(Mask<W>); }
+};
+
+// 共享池中缓冲的总字节数（空闲和借出的合计）；各宽度的空闲列表也由
+// 这把锁保护
+struct MaskBudget {
+    std::mutex mutex;
+    size_t bytes = 0;
+};
+
+MaskBudget& maskBudget() {
+    static MaskBudget budget;
+    return budget;
+}
+
+template <size_t W>
+std::vector<MaskBuffers<W>>& idleMasks() {
+    static std::vector<MaskBuffers<W>> idle;
+    return idle;
+}
+
+// 从共享池借一份至少 n 个顶点的缓冲，析构时归还。池中没有合适的且预算
+// 用尽时单独分配，析构时释放
+template <size_t W>
+class MaskLease {
+   public:
+    explicit MaskLease(size_t n) {
+        MaskBudget& budget = maskBudget();
+        {
+            std::lock_guard<std::mutex> lock(budget.mutex);
+            auto& idle = idleMasks<W>();
+            while (!idle.empty()) {
+                buffers_ = std::move(idle.back());
+                idle.pop_back();
+                if (buffers_.size >= n) {
+                    pooled_ = true;
+                    return;
+                }
+                // 图变大后旧的缓冲不够用，释放并退还预算
+                budget.bytes -= buffers_.Bytes();
+                buffers_ = MaskBuffers<W>();
+            }
+            if (budget.bytes + 2 * n * sizeof(Mask<W>) <= kMaxCachedMaskBytes) {
+                buffers_.Reserve(n);
+                budget.bytes += buffers_.Bytes();
+                pooled_ = true;
+                return;
+            }
+        }
+        buffers_.Reserve(n);
+    }
+
+    ~MaskLease() {
+        if (!pooled_)
+            return;
+        std::lock_guard<std::mutex> lock(maskBudget().mutex);
+        idleMasks<W>().push_back(std::move(buffers_));
+    }
+
+    MaskLease(const MaskLease&) = delete;
+    MaskLease& operator=(const MaskLease&) = delete;
+
+    Mask<W>* Seen() const { return buffers_.seen.get(); }
+    Mask<W>* Next() const { return buffers_.next.get(); }
+
+   private:
+    MaskBuffers<W> buffers_;
+    bool pooled_ = false;
+};
+
+struct BatchQuery {
+    size_t index;  // 在调用方 queries 中的下标
+    uint16_t end_label;
+};
+
+// 对一批（不超过 64 * W 个）边标签条件相同的查询执行 MS-BFS
+template <size_t W>
+void runBatch(const hackathon::GraphStorage& graph,
+              const std::vector<k_hop_count>& queries,
+              const std::vector<BatchQuery>& batch, const EdgeLabels& labels,
+              std::vector<uint64_t>& counts) {
+    MaskLease<W> lease(graph.NodeCount());
+    Mask<W>* seen = lease.Seen();
+    Mask<W>* next = lease.Next();
+    std::vector<uint32_t> touched;
+    std::vector<uint32_t> visited;  // 写入过 seen 的顶点
+    std::vector<std::pair<uint32_t, Mask<W>>> frontier;
+
+    // 结束时（包括异常退出）清零用过的位置，再把缓冲归还共享池
+    struct Cleanup {
+        Mask<W>* seen;
+        Mask<W>* next;
+        const std::vector<uint32_t>& visited;
+        const std::vector<uint32_t>& touched;
+
+        ~Cleanup() {
+            for (uint32_t u : visited) {
+                seen[u] = Mask<W>{};
+            }
+            for (uint32_t u : touched) {
+                next[u] = Mask<W>{};
+            }
+        }
+    } cleanup{seen, next, visited, touched};
+
+    auto reach = [&](uint32_t u, const Mask<W>& m) {
+        if (!any(next[u]))
+            touched.push_back(u);
+        for (size_t i = 0; i < W; ++i) {
+            next[u][i] |= m[i];
+        }
+    };
+
+    int max_length = 0;
+    for (size_t q = 0; q < batch.size(); ++q) {
+        const k_hop_count& query = queries[batch[q].index];
+        max_length = std::max(max_length, query.getLength());
+        Mask<W> bit{};
+        bit[q >> 6] = uint64_t(1) << (q & 63);
+        for (const auto& item : query.getItems()) {
+            uint32_t id = graph.StringToId(item);
+            if (id != static_cast<uint32_t>(-1))
+                reach(id, bit);
+        }
+    }
+
+    // 把 next 中新到达的顶点并入 seen，转成下一层 frontier；count 时统计
+    auto advance = [&](bool count) {
+        frontier.clear();
+        visited.insert(visited.end(), touched.begin(), touched.end());
+        for (uint32_t u : touched) {
+            Mask<W> m = next[u];
+            next[u] = Mask<W>{};
+            for (size_t i = 0; i < W; ++i) {
+                seen[u][i] |= m[i];
+            }
+            frontier.emplace_back(u, m);
+            if (!count)
+                continue;
+            uint16_t label = graph.VertexLabel(u);
+            for (size_t i = 0; i < W; ++i) {
+                for (uint64_t bits = m[i]; bits; bits &= bits - 1) {
+                    const BatchQuery& q = batch[i * 64 + __builtin_ctzll(bits)];
+                    if (q.end_label == hackathon::GraphStorage::kNoLabel ||
+                        q.end_label == label) {
+                        counts[q.index]++;
+                    }
+                }
+            }
+        }
+        touched.clear();
+    };
+    advance(false);
+
+    for (int hop = 0; hop < max_length && !frontier.empty(); ++hop) {
+        // 已走满 k 跳的查询不再扩展
+        Mask<W> alive{};
+        for (size_t q = 0; q < batch.size(); ++q) {
+            if (queries[batch[q].index].getLength() > hop)
+                alive[q >> 6] |= uint64_t(1) << (q & 63);
+        }
+
+        for (auto& [v, m] : frontier) {
+            for (size_t i = 0; i < W; ++i) {
+                m[i] &= alive[i];
+            }
+            if (!any(m))
+                continue;
+            auto expand = [&](uint32_t u) {
+                Mask<W> d;
+                for (size_t i = 0; i < W; ++i) {
+                    d[i] = m[i] & ~seen[u][i];
+                }
+                if (any(d))
+                    reach(u, d);
+                return true;
+            };
+            if (labels.empty()) {
+                graph.OutNeighbors(v).ForEach(expand);
+            } else {
+                forEachAllowed(graph.OutNeighbors(v), graph.OutSegments(v),
+                               labels, 0, SIZE_MAX, expand);
+            }
+        }
+        advance(true);
+    }
+}
+
+}  // namespace
+
+std::vector<uint64_t> kHopCountBatch(const hackathon::GraphStorage& graph,
+                                     const std::vector<k_hop_count>& queries) {
+    std::vector<uint64_t> counts(queries.size(), 0);
+
+    // 按解析后的边标签集合分组，标签不存在的查询结果为 0
+    std::map<EdgeLabels, std::vector<BatchQuery>> groups;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        EdgeLabels labels;
+        uint16_t end_label;
+        if (resolveLabels(graph, queries[i].getLabels(),
+                          queries[i].getEndLabel(), labels, end_label) &&
+            queries[i].getLength() > 0) {
+            groups[labels].push_back({i, end_label});
+        }
+    }
+
+    constexpr size_t kWide = 256;
+    for (const auto& [labels, group] : groups) {
+        for (size_t begin = 0; begin < group.size(); begin += kWide) {
+            size_t end = std::min(group.size(), begin + kWide);
+            std::vector<BatchQuery> batch(group.begin() + begin,
+                                          group.begin() + end);
+            // 掩码宽度按实际批大小取，不足 64 的倍数的批不多占内存
+            if (batch.size() <= 64) {
+                runBatch<1>(graph, queries, batch, labels, counts);
+            } else if (batch.size() <= 128) {
+                runBatch<2>(graph, queries, batch, labels, counts);
+            } else {
+                runBatch<4>(graph, queries, batch, labels, counts);
+            }
+        }
+    }
+    return counts;
+}
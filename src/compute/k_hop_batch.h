@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "graph_storage.h"
+#include "k_hop_count.h"
+
+// 一批 k 跳计数查询共享遍历（multi-source BFS）。
+// 边标签条件相同的查询归为一组，每组最多 256 个一批：每个顶点带一个
+// 位掩码记录这批中哪些查询已访问过它，一次邻居解码同时推进所有查询的
+// frontier。各查询的 k 和终点标签可以不同，到达自己的 k 后对应位不再扩展。
+// 返回值与逐个调用 kHopCount 的结果一一对应。
+std::vector<uint64_t> kHopCountBatch(const hackathon::GraphStorage& graph,
+                                     const std::vector<k_hop_count>& queries);
@@ -0,0 +1,201 @@
+#include "k_hop_cache.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// 每条缓存除键和 bitmap 外的固定开销估计（条目本身 + 哈希表节点）
+constexpr size_t kEntryOverhead = 96;
+
+// 字符串集合规范化为排序去重后的拼接，顺序不同的同一集合共享缓存
+void appendSet(std::vector<std::string> values, std::string& key) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    for (const auto& value : values) {
+        key.append(value);
+        key.push_back('\x1f');
+    }
+    key.push_back('\x1e');
+}
+
+// 遍历进度只取决于起点和边标签
+std::string stateKey(const k_hop_count& query) {
+    std::string key = "S";
+    appendSet(query.getItems(), key);
+    appendSet(query.getLabels(), key);
+    return key;
+}
+
+std::string countKey(const k_hop_count& query) {
+    std::string key = "C";
+    appendSet(query.getItems(), key);
+    appendSet(query.getLabels(), key);
+    key.append(query.getEndLabel());
+    key.push_back('\x1e');
+    key.append(std::to_string(query.getLength()));
+    return key;
+}
+
+}  // namespace
+
+KHopCache::KHopCache(const KHopCacheOptions& options)
+    : options_(options),
+      shard_budget_(options.memory_budget / std::max(1u, options.shards)),
+      shards_(new Shard[std::max(1u, options.shards)]) {
+    options_.shards = std::max(1u, options.shards);
+}
+
+KHopCache::Shard& KHopCache::ShardFor(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % options_.shards];
+}
+
+uint64_t KHopCache::Count(const hackathon::GraphStorage& graph,
+                          const k_hop_count& query,
+                          const KHopOptions& options) {
+    uint64_t count;
+    if (Lookup(query, count))
+        return count;
+
+    KHopState state;
+    std::string state_key;
+    int cached_hops = 0;  // 已缓存进度的跳数，比本查询深时也要记下
+    if (options_.cache_frontiers) {
+        state_key = stateKey(query);
+        std::shared_ptr<const KHopState> cached;
+        if (Find(state_key, nullptr, &cached) && cached) {
+            cached_hops = cached->hops;
+            if (cached->hops <= query.getLength()) {
+                state = *cached;
+                resumed_++;
+                resumed_hops_ += cached->hops;
+            }
+        }
+    }
+
+    count = query.kHopCountFrom(graph, state, options);
+    Store(query, count);
+
+    // 只在走得比缓存的进度更深时替换，浅查询不覆盖更深的进度
+    if (options_.cache_frontiers && state.hops > cached_hops) {
+        size_t bytes =
+            state.visited.Bytes() + state.frontier.Bytes();
+        if (bytes <= options_.max_state_bytes) {
+            Insert(std::move(state_key), 0,
+                   std::make_shared<const KHopState>(std::move(state)), bytes);
+        }
+    }
+    return count;
+}
+
+bool KHopCache::Lookup(const k_hop_count& query, uint64_t& count) {
+    if (Find(countKey(query), &count, nullptr)) {
+        hits_++;
+        return true;
+    }
+    misses_++;
+    return false;
+}
+
+void KHopCache::Store(const k_hop_count& query, uint64_t count) {
+    Insert(countKey(query), count, nullptr, 0);
+}
+
+bool KHopCache::Find(const std::string& key, uint64_t* count,
+                     std::shared_ptr<const KHopState>* state) {
+    Shard& shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+        return false;
+    Entry& entry = shard.ring[it->second];
+    entry.referenced = true;
+    if (count)
+        *count = entry.count;
+    if (state)
+        *state = entry.state;
+    return true;
+}
+
+void KHopCache::Insert(std::string key, uint64_t count,
+                       std::shared_ptr<const KHopState> state,
+                       size_t state_bytes) {
+    size_t bytes = kEntryOverhead + 2 * key.size() + state_bytes;
+    if (bytes > shard_budget_)
+        return;
+    Shard& shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        Entry& entry = shard.ring[it->second];
+        shard.bytes = shard.bytes - entry.bytes + bytes;
+        entry.count = count;
+        entry.state = std::move(state);
+        entry.bytes = bytes;
+        entry.referenced = true;
+    } else {
+        while (shard.bytes + bytes > shard_budget_ && !shard.index.empty()) {
+            EvictOne(shard);
+        }
+        size_t slot;
+        if (!shard.free_slots.empty()) {
+            slot = shard.free_slots.back();
+            shard.free_slots.pop_back();
+        } else {
+            slot = shard.ring.size();
+            shard.ring.emplace_back();
+        }
+        // 新条目不置引用位，只被访问一次的条目先被淘汰
+        shard.ring[slot] = {key, count, std::move(state), bytes, false};
+        shard.index.emplace(std::move(key), slot);
+        shard.bytes += bytes;
+    }
+}
+
+void KHopCache::EvictOne(Shard& shard) {
+    while (true) {
+        Entry& entry = shard.ring[shard.hand];
+        size_t slot = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.ring.size();
+        if (entry.key.empty())
+            continue;
+        if (entry.referenced) {
+            entry.referenced = false;
+            continue;
+        }
+        shard.bytes -= entry.bytes;
+        shard.index.erase(entry.key);
+        entry = Entry();
+        shard.free_slots.push_back(slot);
+        evictions_++;
+        return;
+    }
+}
+
+KHopCache::Stats KHopCache::GetStats() const {
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.resumed = resumed_;
+    stats.resumed_hops = resumed_hops_;
+    stats.evictions = evictions_;
+    for (unsigned i = 0; i < options_.shards; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.entries += shard.index.size();
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
+
+void KHopCache::Clear() {
+    for (unsigned i = 0; i < options_.shards; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.ring.clear();
+        shard.index.clear();
+        shard.free_slots.clear();
+        shard.hand = 0;
+        shard.bytes = 0;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "graph_storage.h"
+#include "k_hop_count.h"
+
+struct KHopCacheOptions {
+    // 所有分片合计的内存上限（键、计数和 frontier bitmap）
+    size_t memory_budget = size_t(256) << 20;
+    unsigned shards = 16;
+    // 是否缓存遍历进度（已访问集合 + frontier），供更大的 k 继续扩展
+    bool cache_frontiers = true;
+    // 单条遍历进度超过该大小时不缓存，避免一条大查询挤掉大量计数
+    size_t max_state_bytes = size_t(8) << 20;
+};
+
+// k 跳计数的结果缓存，放在引擎前面。
+// 按 (起点集合, k, 边标签集合, 终点标签) 缓存最终计数；可选地按
+// (起点集合, 边标签集合) 缓存最深一次的遍历进度（VertexSet），
+// k 更大的查询从中继续，只补走剩下的跳数。
+// 键按哈希分片，每片一把锁和一个 CLOCK 环：命中置引用位，
+// 超出内存上限时指针扫过环，清掉引用位，淘汰第一个未被引用的条目。
+// 缓存绑定一个图，图重建后需 Clear。
+class KHopCache {
+   public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t resumed = 0;  // 未命中但从缓存的遍历进度继续
+        uint64_t resumed_hops = 0;  // 从缓存进度继续时省去的跳数合计
+        uint64_t evictions = 0;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+    };
+
+    explicit KHopCache(const KHopCacheOptions& options = {});
+
+    KHopCache(const KHopCache&) = delete;
+    KHopCache& operator=(const KHopCache&) = delete;
+
+    // 命中直接返回，否则（可能从缓存的进度继续）执行并写入缓存
+    uint64_t Count(const hackathon::GraphStorage& graph,
+                   const k_hop_count& query, const KHopOptions& options = {});
+
+    // 只查计数缓存，供批量接口先过滤命中的查询
+    bool Lookup(const k_hop_count& query, uint64_t& count);
+    void Store(const k_hop_count& query, uint64_t count);
+
+    Stats GetStats() const;
+    void Clear();
+
+   private:
+    struct Entry {
+        std::string key;
+        uint64_t count = 0;
+        std::shared_ptr<const KHopState> state;
+        size_t bytes = 0;
+        bool referenced = false;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::vector<Entry> ring;  // CLOCK 环，空槽 key 为空
+        std::unordered_map<std::string, size_t> index;  // key -> ring 下标
+        std::vector<size_t> free_slots;
+        size_t hand = 0;
+        size_t bytes = 0;
+    };
+
+    Shard& ShardFor(const std::string& key);
+    bool Find(const std::string& key, uint64_t* count,
+              std::shared_ptr<const KHopState>* state);
+    void Insert(std::string key, uint64_t count,
+                std::shared_ptr<const KHopState> state, size_t state_bytes);
+    void EvictOne(Shard& shard);
+
+    KHopCacheOptions options_;
+    size_t shard_budget_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> resumed_{0};
+    std::atomic<uint64_t> resumed_hops_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
@@ -0,0 +1,403 @@
+#include "k_hop_count.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "label_filter.h"
+#include "thread_pool.h"
+
+namespace {
+
+// 邻居先攒成批再 addMany，避免逐个插入 bitmap
+constexpr size_t kNeighborBatch = 4096;
+// 每个参与线程平均分到的任务数，越多负载越均衡
+constexpr uint64_t kTasksPerThread = 8;
+constexpr uint64_t kMinTaskWork = 4096;
+// 自底向上每个任务处理的位图字数（64 个顶点一字）
+constexpr size_t kBottomUpTaskWords = 512;
+
+// 依次对 vertices 调用 fn，同时按 distance 流水预取：共 L 级预取时，
+// 第 k 级（从 1 起）在处理第 i 个顶点时作用于第 i + (L - k + 1) * distance 个，
+// 前一级取到的数据供后一级使用。distance 为 0 时不预取
+template <typename Fn, typename... Stages>
+void forEachPrefetched(const uint32_t* vertices, size_t n, size_t distance,
+                       Fn&& fn, Stages&&... stages) {
+    if (distance == 0) {
+        for (size_t i = 0; i < n; ++i) {
+            fn(vertices[i]);
+        }
+        return;
+    }
+    ptrdiff_t count = n;
+    ptrdiff_t lead = sizeof...(Stages) * distance;
+    for (ptrdiff_t i = -lead; i < count; ++i) {
+        ptrdiff_t target = i + lead;
+        (
+            [&] {
+                if (target >= 0 && target < count)
+                    stages(vertices[target]);
+                target -= distance;
+            }(),
+            ...);
+        if (i >= 0)
+            fn(vertices[i]);
+    }
+}
+
+// 每个参与线程私有的下一层 frontier，按 kind 积累：数组和 roaring 先攒批，
+// 平铺位图时所有线程直接在共享位图上置位
+struct LocalFrontier {
+    VertexSet::Kind kind = VertexSet::Kind::kRoaring;
+    DenseBitset* dense = nullptr;
+    bool shared = false;  // 其他线程也可能写同一字
+    std::vector<uint32_t> batch;
+    std::vector<uint32_t> candidates;  // 自底向上时本任务的未访问顶点
+    roaring::Roaring next;
+
+    void push(uint32_t v) {
+        if (dense) {
+            if (shared)
+                dense->AtomicSet(v);
+            else
+                dense->Set(v);
+            return;
+        }
+        batch.push_back(v);
+        if (kind == VertexSet::Kind::kRoaring && batch.size() >= kNeighborBatch)
+            flush();
+    }
+
+    void flush() {
+        next.addMany(batch.size(), batch.data());
+        batch.clear();
+    }
+};
+
+// 串行或在共享线程池上执行 task_count 个任务，各线程的输出合并为
+// kind 表示的下一层 frontier（未去掉已访问顶点）
+VertexSet runLevel(bool parallel, size_t task_count, VertexSet::Kind kind,
+                   uint32_t node_count,
+                   const std::function<void(size_t, LocalFrontier&)>& fn) {
+    DenseBitset dense;
+    if (kind == VertexSet::Kind::kDense)
+        dense = DenseBitset(node_count);
+    auto& pool = hackathon::WorkStealingPool::Shared();
+    std::vector<LocalFrontier> locals(parallel ? pool.Concurrency() : 1);
+    for (auto& local : locals) {
+        local.kind = kind;
+        local.dense = kind == VertexSet::Kind::kDense ? &dense : nullptr;
+        local.shared = parallel;
+    }
+    if (!parallel) {
+        for (size_t t = 0; t < task_count; ++t) {
+            fn(t, locals[0]);
+        }
+    } else {
+        pool.ParallelFor(task_count, [&](size_t t, unsigned participant) {
+            fn(t, locals[participant]);
+        });
+    }
+
+    switch (kind) {
+        case VertexSet::Kind::kDense:
+            return VertexSet::FromDense(std::move(dense));
+        case VertexSet::Kind::kSparse: {
+            std::vector<uint32_t> vertices = std::move(locals[0].batch);
+            for (size_t i = 1; i < locals.size(); ++i) {
+                vertices.insert(vertices.end(), locals[i].batch.begin(),
+                                locals[i].batch.end());
+            }
+            std::sort(vertices.begin(), vertices.end());
+            vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                           vertices.end());
+            return VertexSet::FromSorted(std::move(vertices));
+        }
+        case VertexSet::Kind::kRoaring:
+            break;
+    }
+    std::vector<const roaring::Roaring*> parts;
+    for (auto& local : locals) {
+        local.flush();
+        parts.push_back(&local.next);
+    }
+    if (parts.size() == 1)
+        return VertexSet::FromRoaring(std::move(locals[0].next));
+    return VertexSet::FromRoaring(
+        roaring::Roaring::fastunion(parts.size(), parts.data()));
+}
+
+// 自顶向下：展开 frontier 所有顶点的出边。
+// frontier 按出边量切成均衡任务；超过单任务工作量的顶点，其邻居表按下标拆给
+// 多个任务，避免一个 hub 拖慢整层。
+// 出边总量是下一层规模的上界，按它选择输出表示。
+// 预取只有 offsets 和邻居数据两级：展开时不逐个查已访问集合（层末整体做差集），
+// 没有按邻居随机读已访问位图的访问可预取
+VertexSet topDownStep(const hackathon::GraphStorage& graph,
+                      const VertexSet& frontier, const EdgeLabels& labels,
+                      const KHopOptions& options) {
+    std::vector<uint32_t> vertices;
+    frontier.ToArray(vertices);
+    std::vector<uint64_t> weights(vertices.size());
+    uint64_t work = 0;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        weights[i] = graph.OutDegree(vertices[i]) + 1;
+        work += weights[i];
+    }
+
+    struct Task {
+        size_t begin;
+        size_t end;
+        uint32_t part;
+        uint32_t parts;
+    };
+    std::vector<Task> tasks;
+    bool parallel = options.parallel && work >= options.parallel_min_work;
+    size_t distance = vertices.size() * options.prefetch_sparse_ratio >
+                              graph.NodeCount()
+                          ? 0
+                          : options.prefetch_distance;
+    if (!parallel) {
+        tasks.push_back({0, vertices.size(), 0, 1});
+    } else {
+        uint64_t threads = hackathon::WorkStealingPool::Shared().Concurrency();
+        uint64_t target =
+            std::max(work / (threads * kTasksPerThread), kMinTaskWork);
+        for (size_t i = 0; i < vertices.size();) {
+            if (weights[i] > target) {
+                uint32_t parts = (weights[i] + target - 1) / target;
+                for (uint32_t p = 0; p < parts; ++p) {
+                    tasks.push_back({i, i + 1, p, parts});
+                }
+                ++i;
+                continue;
+            }
+            size_t begin = i;
+            uint64_t acc = 0;
+            while (i < vertices.size() && weights[i] <= target &&
+                   acc + weights[i] <= target) {
+                acc += weights[i++];
+            }
+            tasks.push_back({begin, i, 0, 1});
+        }
+    }
+
+    auto kind = VertexSet::Choose(work, graph.NodeCount(), options.dense_ratio,
+                                  options.sparse_ratio);
+    return runLevel(parallel, tasks.size(), kind, graph.NodeCount(),
+                    [&](size_t t, LocalFrontier& local) {
+        const Task& task = tasks[t];
+        auto emit = [&local](uint32_t u) { local.push(u); };
+        auto emit_all = [&local](uint32_t u) {
+            local.push(u);
+            return true;
+        };
+        if (!labels.empty()) {
+            forEachPrefetched(
+                vertices.data() + task.begin, task.end - task.begin,
+                task.parts == 1 ? distance : 0,
+                [&](uint32_t v) {
+                    auto segments = graph.OutSegments(v);
+                    size_t degree = allowedDegree(segments, labels);
+                    forEachAllowed(graph.OutNeighbors(v), segments, labels,
+                                   degree * task.part / task.parts,
+                                   degree * (task.part + 1) / task.parts,
+                                   emit_all);
+                },
+                [&](uint32_t v) { graph.PrefetchOutIndex(v, true); },
+                [&](uint32_t v) { graph.PrefetchOutData(v, true); });
+            return;
+        }
+        if (task.parts == 1) {
+            forEachPrefetched(
+                vertices.data() + task.begin, task.end - task.begin, distance,
+                [&](uint32_t v) { graph.OutNeighbors(v).ForEach(emit); },
+                [&](uint32_t v) { graph.PrefetchOutIndex(v, false); },
+                [&](uint32_t v) { graph.PrefetchOutData(v, false); });
+            return;
+        }
+        // 拆分的高度数顶点：各部分跳过起点之前的整段，从所在段的恢复点解码
+        uint32_t v = vertices[task.begin];
+        size_t degree = graph.OutDegree(v);
+        size_t first = degree * task.part / task.parts;
+        size_t last = degree * (task.part + 1) / task.parts;
+        auto segments = graph.OutSegments(v);
+        if (segments.empty()) {
+            graph.OutNeighbors(v).ForEachInRange(first, last, emit);
+            return;
+        }
+        forEachAllowed(graph.OutNeighbors(v), segments, labels, first, last,
+                       emit_all);
+    });
+}
+
+// 自底向上：每个未访问顶点扫描入边，遇到 frontier 中的父节点即提前结束。
+// 输出为平铺位图，只含未访问顶点；任务按位图字划分，各自写不相交的字
+VertexSet bottomUpStep(const hackathon::GraphStorage& graph,
+                       const DenseBitset& frontier_bits,
+                       const DenseBitset& visited_bits,
+                       const EdgeLabels& labels, const KHopOptions& options) {
+    uint32_t node_count = graph.NodeCount();
+    size_t words = visited_bits.Words();
+    bool parallel = options.parallel && node_count >= options.parallel_min_work;
+    size_t task_count =
+        parallel ? (words + kBottomUpTaskWords - 1) / kBottomUpTaskWords : 1;
+    // 按顶点顺序扫描入边，只有 frontier 位图是随机访问，位图留在缓存中时
+    // 不值得为预取多解码一次首个父节点
+    size_t distance =
+        labels.empty() && words >= options.prefetch_min_bitmap_words
+            ? options.prefetch_distance
+            : 0;
+
+    return runLevel(parallel, task_count, VertexSet::Kind::kDense, node_count,
+                    [&](size_t t, LocalFrontier& local) {
+        // 任务按位图字划分，写入的字互不重叠，不需要原子操作
+        local.shared = false;
+        size_t begin = parallel ? t * kBottomUpTaskWords : 0;
+        size_t end = parallel ? std::min(words, begin + kBottomUpTaskWords)
+                              : words;
+        auto has_parent = [&](uint32_t parent) {
+            return !frontier_bits.Test(parent);
+        };
+        auto scan = [&](uint32_t v) {
+            if (!labels.empty()) {
+                if (!forEachAllowed(graph.InNeighbors(v), graph.InSegments(v),
+                                    labels, 0, SIZE_MAX, has_parent)) {
+                    local.push(v);
+                }
+                return;
+            }
+            for (uint32_t parent : graph.InNeighbors(v)) {
+                if (frontier_bits.Test(parent)) {
+                    local.push(v);
+                    break;
+                }
+            }
+        };
+        // 父节点按序检查，预取第一个父节点所在的 frontier 位图字
+        auto prefetch_parent = [&](uint32_t v) {
+            auto parents = graph.InNeighbors(v);
+            if (!parents.empty())
+                __builtin_prefetch(frontier_bits.Data() +
+                                   (*parents.begin() >> 6));
+        };
+
+        // 未访问顶点按块收集后流水处理，串行时也不一次收集整张图
+        auto& candidates = local.candidates;
+        for (size_t block = begin; block < end; block += kBottomUpTaskWords) {
+            candidates.clear();
+            size_t block_end = std::min(end, block + kBottomUpTaskWords);
+            for (size_t w = block; w < block_end; ++w) {
+                uint64_t unvisited = ~visited_bits.Data()[w];
+                while (unvisited) {
+                    uint32_t v = (w << 6) + __builtin_ctzll(unvisited);
+                    unvisited &= unvisited - 1;
+                    if (v >= node_count)
+                        break;
+                    candidates.push_back(v);
+                }
+            }
+            forEachPrefetched(candidates.data(), candidates.size(), distance,
+                              scan, prefetch_parent);
+        }
+    });
+}
+
+}  // namespace
+
+roaring::Roaring k_hop_count::sourceIds(
+    const hackathon::GraphStorage& graph) const {
+    roaring::Roaring sources;
+    for (const auto& item : items_) {
+        uint32_t id = graph.StringToId(item);
+        if (id != static_cast<uint32_t>(-1))
+            sources.add(id);
+    }
+    return sources;
+}
+
+uint64_t k_hop_count::kHopCount(const hackathon::GraphStorage& graph,
+                                const KHopOptions& options) const {
+    KHopState state;
+    return kHopCountFrom(graph, state, options);
+}
+
+uint64_t k_hop_count::kHopCountFrom(const hackathon::GraphStorage& graph,
+                                    KHopState& state,
+                                    const KHopOptions& options) const {
+    // 标签在图中不存在时没有可走的边或可计数的终点
+    EdgeLabels labels;
+    uint16_t end_label;
+    if (!resolveLabels(graph, labels_, endLabel_, labels, end_label))
+        return 0;
+
+    uint32_t node_count = graph.NodeCount();
+    auto adapt = [&](VertexSet& set) {
+        set.Convert(VertexSet::Choose(set.Size(), node_count,
+                                      options.dense_ratio,
+                                      options.sparse_ratio),
+                    node_count);
+    };
+
+    roaring::Roaring sources = sourceIds(graph);
+    if (state.hops == 0) {
+        state.frontier = VertexSet::FromRoaring(sources);
+        adapt(state.frontier);
+        state.visited = state.frontier;
+    }
+    VertexSet& frontier = state.frontier;
+    VertexSet& visited = state.visited;
+
+    uint64_t edge_count = graph.EdgeCount();
+    bool direction_optimizing = options.direction_optimizing &&
+                                edge_count > 0 && options.alpha > 0 &&
+                                options.beta > 0;
+    bool bottom_up = false;
+
+    for (; state.hops < length_ && !frontier.Empty(); ++state.hops) {
+        if (direction_optimizing) {
+            uint64_t frontier_size = frontier.Size();
+            if (!bottom_up) {
+                uint64_t frontier_edges = frontier_size;
+                frontier.ForEach(
+                    [&](uint32_t v) { frontier_edges += graph.OutDegree(v); });
+                bottom_up = frontier_edges > edge_count / options.alpha;
+            } else if (frontier_size < node_count / options.beta) {
+                bottom_up = false;
+            }
+        }
+
+        VertexSet next;
+        if (bottom_up) {
+            // 自底向上按位检查 frontier 并逐字扫描未访问顶点，两者都要平铺位图
+            frontier.Convert(VertexSet::Kind::kDense, node_count);
+            visited.Convert(VertexSet::Kind::kDense, node_count);
+            next = bottomUpStep(graph, frontier.Dense(), visited.Dense(),
+                                labels, options);
+        } else {
+            next = topDownStep(graph, frontier, labels, options);
+            next.Subtract(visited);
+        }
+
+        // 已访问集合只增不减，转为平铺位图后不再降级；其余按新规模重选表示
+        visited.Unite(next);
+        if (visited.GetKind() != VertexSet::Kind::kDense)
+            adapt(visited);
+        adapt(next);
+        frontier = std::move(next);
+    }
+    // frontier 为空时后续各跳都不会再有新顶点
+    if (frontier.Empty())
+        state.hops = std::max(state.hops, length_);
+
+    uint64_t count = 0;
+    if (end_label == hackathon::GraphStorage::kNoLabel) {
+        count = visited.Size();
+        for (uint32_t v : sources) {
+            count -= visited.Contains(v);
+        }
+        return count;
+    }
+    visited.ForEach([&](uint32_t v) {
+        count += graph.VertexLabel(v) == end_label && !sources.contains(v);
+    });
+    return count;
+}
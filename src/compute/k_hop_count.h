@@ -1,21 +1,75 @@
-// #include "deps/CRoaring/include/roaring/roaring.h"
+#pragma once
 
 #include <stdint.h>
-#include <iostream>
+#include <string>
 #include <vector>
+#include "graph_storage.h"
+#include "roaring/roaring.hh"
+#include "vertex_set.h"
 
+// k 跳遍历的可调参数
+struct KHopOptions {
+    // 按 frontier 规模在自顶向下（push）与自底向上（pull）之间切换
+    bool direction_optimizing = true;
+    // frontier 顶点数 + 出边数 > 总边数 / alpha 时切到自底向上
+    uint32_t alpha = 15;
+    // 自底向上时 frontier 顶点数 < 总顶点数 / beta 则切回自顶向下
+    uint32_t beta = 18;
+    // 单层工作量（自顶向下为 frontier 出边量，自底向上为顶点数）超过
+    // parallel_min_work 时在共享工作窃取线程池上并行扩展
+    bool parallel = true;
+    uint64_t parallel_min_work = 1 << 16;
+    // 扩展时提前多少个顶点发出软件预取，0 表示关闭。自顶向下在稀疏 frontier
+    // 上依次预取 offsets（提前两倍距离）和邻居数据（提前一倍）；自底向上在
+    // 位图超出缓存时预取首个父节点所在的 frontier 位图字
+    uint32_t prefetch_distance = 8;
+    // 预取的启用门槛。frontier 超过总顶点数 / prefetch_sparse_ratio 时顶点
+    // 近乎连续，硬件预取已足够，自顶向下不再预取（0 表示总是预取）；
+    // frontier 位图小于 prefetch_min_bitmap_words 个字时基本留在缓存中，
+    // 自底向上不预取
+    uint32_t prefetch_sparse_ratio = 16;
+    uint64_t prefetch_min_bitmap_words = uint64_t(1) << 20;
+    // frontier 与已访问集合按密度选择表示（见 VertexSet::Choose）：
+    // 不超过总顶点数 / sparse_ratio 用有序数组，不少于总顶点数 / dense_ratio
+    // 用平铺位图，其间用 roaring；0 表示不用该表示
+    uint32_t sparse_ratio = 1024;
+    uint32_t dense_ratio = 32;
+};
+
+// 遍历进度：走完 hops 跳后的已访问集合（含起点）与当前 frontier。
+// 同一起点和标签条件的更深查询可以从这里继续，不必从头扩展。
+struct KHopState {
+    int hops = 0;
+    VertexSet visited;
+    VertexSet frontier;
+};
+
+// k 跳邻居计数：从 items_ 中的起点出发，沿出边扩展 length_ 跳，
+// 返回可达的不同顶点数（不含起点本身）。
+// 已访问集合与每层 frontier 按密度在有序数组、roaring bitmap 和平铺位图间切换：
+// 前几跳的少量顶点直接排序去重，大集合的差集、并集和最终计数走 AVX2 整块运算。
+// frontier 变大后切换为自底向上：
+// 遍历未访问顶点的入边，找到第一个位于 frontier 的父节点即停止。
+// 大 frontier 按度数切成均衡的任务并行扩展，高度数顶点的邻居表拆给多个任务，
+// 各线程写入自己的缓冲层末合并，输出为平铺位图时直接置位。
+// labels_ 非空时只沿这些边标签扩展，邻居表按边标签分段，其他段整段跳过；
+// endLabel_ 非空时只统计该顶点标签的终点，中间顶点不受限制。
 class k_hop_count {
-   private:
    private:
     std::vector<std::string> items_;  // string 类型的列表（主数据）
-    int length_;  // int 类型的长度（可选：你也可以用 size_t）
+    int length_ = 0;  // int 类型的长度（可选：你也可以用 size_t）
     std::vector<std::string> labels_;  // string 类型的 label 列表
+    std::string endLabel_;             // 终点顶点标签，空表示不限
                                        //初始化接口
    public:
-    uint64_t kHopCount() const {
-        std::cout << "uuuuu";
-        return 0;
-    };
+    uint64_t kHopCount(const hackathon::GraphStorage& graph,
+                       const KHopOptions& options = {}) const;
+
+    // 从 state 继续扩展到 length_ 跳并更新 state；state.hops 为 0 时从起点
+    // 开始，否则必须来自同一起点和边标签条件且 state.hops <= length_
+    uint64_t kHopCountFrom(const hackathon::GraphStorage& graph,
+                           KHopState& state,
+                           const KHopOptions& options = {}) const;
 
     // 构造函数（可选：提供默认构造、带参构造等）
     k_hop_count() = default;
@@ -38,10 +92,18 @@ class k_hop_count {
 
     const std::vector<std::string>& getLabels() const { return labels_; }
 
+    const std::string& getEndLabel() const { return endLabel_; }
+
     // Setter（按需添加）
     void setItems(const std::vector<std::string>& items) { items_ = items; }
 
     void setLength(int length) { length_ = length; }
 
     void setLabels(const std::vector<std::string>& labels) { labels_ = labels; }
+
+    void setEndLabel(const std::string& label) { endLabel_ = label; }
+
+   private:
+    // 起点对应的顶点 ID，忽略不存在的节点
+    roaring::Roaring sourceIds(const hackathon::GraphStorage& graph) const;
 };
@@ -0,0 +1,88 @@
+#include "k_hop_reach.h"
+#include <cstdint>
+#include <unordered_set>
+#include "label_filter.h"
+
+namespace {
+
+// 一侧的扩展状态：depth 跳以内的已访问顶点与第 depth 层的 frontier
+struct Side {
+    std::unordered_set<uint32_t> seen;
+    std::vector<uint32_t> frontier;
+    int depth = 0;
+    bool forward;
+};
+
+// 把 side 扩展一层。新顶点在对侧已访问集合中时返回 true。
+// 两侧此前不相交，所以相遇的顶点必在对侧最深一层，距离为两侧深度之和
+bool expand(const hackathon::GraphStorage& graph, Side& side,
+            const Side& other, const EdgeLabels& labels) {
+    std::vector<uint32_t> next;
+    bool met = false;
+    auto visit = [&](uint32_t u) {
+        if (other.seen.count(u)) {
+            met = true;
+            return false;
+        }
+        if (side.seen.insert(u).second)
+            next.push_back(u);
+        return true;
+    };
+    for (uint32_t v : side.frontier) {
+        auto neighbors =
+            side.forward ? graph.OutNeighbors(v) : graph.InNeighbors(v);
+        if (labels.empty()) {
+            for (uint32_t u : neighbors) {
+                if (!visit(u))
+                    break;
+            }
+        } else {
+            forEachAllowed(neighbors,
+                           side.forward ? graph.OutSegments(v)
+                                        : graph.InSegments(v),
+                           labels, 0, SIZE_MAX, visit);
+        }
+        if (met)
+            break;
+    }
+    side.frontier = std::move(next);
+    side.depth++;
+    return met;
+}
+
+}  // namespace
+
+KHopReach kHopReach(const hackathon::GraphStorage& graph,
+                    std::string_view source, std::string_view target, int k,
+                    const std::vector<std::string>& labels) {
+    KHopReach result;
+    EdgeLabels allowed;
+    uint16_t end_label;
+    if (!resolveLabels(graph, labels, "", allowed, end_label))
+        return result;
+    uint32_t from = graph.StringToId(source);
+    uint32_t to = graph.StringToId(target);
+    if (from == static_cast<uint32_t>(-1) || to == static_cast<uint32_t>(-1))
+        return result;
+    if (from == to) {
+        result.reachable = k >= 0;
+        result.distance = result.reachable ? 0 : -1;
+        return result;
+    }
+
+    Side forward{{from}, {from}, 0, true};
+    Side backward{{to}, {to}, 0, false};
+    while (forward.depth + backward.depth < k && !forward.frontier.empty() &&
+           !backward.frontier.empty()) {
+        Side& side = forward.frontier.size() <= backward.frontier.size()
+                         ? forward
+                         : backward;
+        Side& other = &side == &forward ? backward : forward;
+        if (expand(graph, side, other, allowed)) {
+            result.reachable = true;
+            result.distance = forward.depth + backward.depth;
+            break;
+        }
+    }
+    return result;
+}
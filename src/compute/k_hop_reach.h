@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "graph_storage.h"
+
+// 点到点 k 跳可达查询的结果
+struct KHopReach {
+    bool reachable = false;
+    int distance = -1;  // 最短跳数，不可达时为 -1
+};
+
+// target 是否在 source 的 k 跳以内，以及最短跳数。
+// 双向扩展：从 source 沿出边、从 target 沿入边，每次整层扩展顶点数较少的
+// 一侧，两侧已访问集合第一次相交即得到最短距离。两侧深度之和到 k 或
+// 任一侧 frontier 为空时不可达。最坏工作量约为 O(d^(k/2))，单向为 O(d^k)。
+// labels 非空时只沿这些边标签扩展；起点或终点不存在时不可达。
+KHopReach kHopReach(const hackathon::GraphStorage& graph,
+                    std::string_view source, std::string_view target, int k,
+                    const std::vector<std::string>& labels = {});
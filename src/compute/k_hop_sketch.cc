@@ -0,0 +1,308 @@
+#include "k_hop_sketch.h"
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include "thread_pool.h"
+
+namespace {
+
+constexpr char kSketchMagic[8] = "HKANF01";
+constexpr uint32_t kMinLog2m = 4;
+constexpr uint32_t kMaxLog2m = 16;
+// 构建时每个任务处理的顶点数
+constexpr size_t kSketchTaskVertices = 4096;
+// 后台构建线程的 nice 值
+constexpr int kSketchNice = 10;
+constexpr char kSidecarName[] = "khop_sketches.hkg";
+
+// memory_budget 内能放下的精度和半径数：先按 options 的精度减少半径，
+// 一个半径也放不下时逐级降低精度。hops 为 0 表示不构建
+struct SketchPlan {
+    uint32_t log2m;
+    uint64_t hops;
+};
+
+SketchPlan planSketches(const KHopSketchOptions& options,
+                        uint64_t node_count) {
+    SketchPlan plan{std::clamp(options.log2m, kMinLog2m, kMaxLog2m), 0};
+    uint64_t max_hops = std::max(options.max_hops, 0);
+    while (true) {
+        size_t per_hop = node_count << plan.log2m;
+        plan.hops = per_hop > 0 ? std::min<uint64_t>(
+                                      max_hops, options.memory_budget / per_hop)
+                                : max_hops;
+        if (plan.hops > 0 || max_hops == 0 || plan.log2m == kMinLog2m)
+            return plan;
+        --plan.log2m;
+    }
+}
+
+// splitmix64 的末段，把相邻的顶点 ID 打散到整个 64 位
+inline uint64_t mixHash(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 高 log2m 位选寄存器，其余位的前导零个数 + 1 为秩
+inline void addVertex(uint8_t* registers, uint32_t log2m, uint32_t v) {
+    uint64_t hash = mixHash(v);
+    uint64_t index = hash >> (64 - log2m);
+    uint64_t rest = hash << log2m;
+    uint8_t rank = rest ? __builtin_clzll(rest) + 1 : 64 - log2m + 1;
+    registers[index] = std::max(registers[index], rank);
+}
+
+// 草图取并，逐字节取最大值（编译器向量化为 vpmaxub）
+inline void mergeRegisters(uint8_t* dst, const uint8_t* src, size_t m) {
+    for (size_t i = 0; i < m; ++i) {
+        dst[i] = std::max(dst[i], src[i]);
+    }
+}
+
+// HyperLogLog 估计，小基数时改用线性计数
+double estimateRegisters(const uint8_t* registers, size_t m) {
+    double sum = 0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < m; ++i) {
+        sum += std::ldexp(1.0, -registers[i]);
+        zeros += registers[i] == 0;
+    }
+    double alpha = m == 16   ? 0.673
+                   : m == 32 ? 0.697
+                   : m == 64 ? 0.709
+                             : 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * std::log(double(m) / zeros);
+    return estimate;
+}
+
+}  // namespace
+
+std::unique_ptr<KHopSketches> KHopSketches::Build(
+    const hackathon::GraphStorage& graph, const KHopSketchOptions& options) {
+    uint64_t node_count = graph.NodeCount();
+    SketchPlan plan = planSketches(options, node_count);
+    if (plan.hops == 0) {
+        if (options.max_hops > 0)
+            std::cerr << "k-hop sketches disabled: " << node_count
+                      << " vertices need " << (node_count << kMinLog2m)
+                      << " bytes per radius, memory budget is "
+                      << options.memory_budget << " bytes" << std::endl;
+        return nullptr;
+    }
+    uint32_t requested = std::clamp(options.log2m, kMinLog2m, kMaxLog2m);
+    if (plan.log2m < requested)
+        std::cerr << "k-hop sketches: log2m lowered from " << requested
+                  << " to " << plan.log2m << " to fit the memory budget"
+                  << std::endl;
+    if (plan.hops < uint64_t(options.max_hops))
+        std::cerr << "k-hop sketches: " << plan.hops << " of "
+                  << options.max_hops << " radii fit the memory budget"
+                  << std::endl;
+    uint32_t log2m = plan.log2m;
+    uint64_t hops = plan.hops;
+    size_t m = size_t(1) << log2m;
+    size_t per_hop = node_count * m;
+
+    std::unique_ptr<KHopSketches> sketches(new KHopSketches());
+    Header& header = sketches->header_;
+    std::memcpy(header.magic, kSketchMagic, sizeof(header.magic));
+    header.log2m = log2m;
+    header.node_count = node_count;
+    header.edge_count = graph.EdgeCount();
+    header.graph_checksum = graph.GraphFileChecksum();
+    auto& owned = sketches->owned_;
+    owned.assign(sizeof(Header) + hops * per_hop, 0);
+    uint8_t* registers = owned.data() + sizeof(Header);
+
+    // 独立的小线程池，不占用查询使用的共享线程池
+    unsigned threads = options.threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency() / 4);
+    hackathon::WorkStealingPool pool(threads);
+    size_t task_count =
+        (node_count + kSketchTaskVertices - 1) / kSketchTaskVertices;
+    for (uint64_t t = 1; t <= hops; ++t) {
+        uint8_t* out = registers + (t - 1) * per_hop;
+        const uint8_t* prev = t > 1 ? out - per_hop : nullptr;
+        std::atomic<bool> changed{prev == nullptr};
+        pool.ParallelFor(task_count, [&](size_t task, unsigned) {
+            uint64_t begin = task * kSketchTaskVertices;
+            uint64_t end = std::min(node_count, begin + kSketchTaskVertices);
+            bool task_changed = false;
+            for (uint64_t v = begin; v < end; ++v) {
+                uint8_t* dst = out + v * m;
+                if (!prev) {
+                    addVertex(dst, log2m, v);
+                    graph.OutNeighbors(v).ForEach(
+                        [&](uint32_t u) { addVertex(dst, log2m, u); });
+                    continue;
+                }
+                std::memcpy(dst, prev + v * m, m);
+                graph.OutNeighbors(v).ForEach([&](uint32_t u) {
+                    mergeRegisters(dst, prev + size_t(u) * m, m);
+                });
+                task_changed =
+                    task_changed || std::memcmp(dst, prev + v * m, m) != 0;
+            }
+            if (task_changed)
+                changed.store(true, std::memory_order_relaxed);
+        });
+        header.hops = t;
+        // 本轮没有变化：之后各半径都与上一轮相同，丢掉本轮
+        if (!changed.load()) {
+            header.hops = t - 1;
+            header.converged = 1;
+            owned.resize(sizeof(Header) + header.hops * per_hop);
+            break;
+        }
+    }
+    std::memcpy(owned.data(), &header, sizeof(Header));
+    sketches->data_ = owned.data() + sizeof(Header);
+    return sketches;
+}
+
+std::unique_ptr<KHopSketches> KHopSketches::Open(
+    const std::string& path, const hackathon::GraphStorage& graph,
+    const KHopSketchOptions& options) {
+    if (path.empty() || !std::filesystem::exists(path))
+        return nullptr;
+    auto file = std::make_unique<hackathon::GraphFile>();
+    try {
+        file->Open(path);
+    } catch (const std::exception&) {
+        return nullptr;  // 损坏的草图容器重新构建即可
+    }
+    auto section = file->Section(hackathon::GraphSection::kHopSketches);
+    Header header;
+    if (section.size() < sizeof(Header))
+        return nullptr;
+    std::memcpy(&header, section.data(), sizeof(Header));
+    SketchPlan plan = planSketches(options, graph.NodeCount());
+    if (std::memcmp(header.magic, kSketchMagic, sizeof(header.magic)) != 0 ||
+        header.log2m != plan.log2m || header.node_count != graph.NodeCount() ||
+        header.edge_count != graph.EdgeCount() ||
+        header.graph_checksum != graph.GraphFileChecksum() ||
+        section.size() != sizeof(Header) + header.hops * header.node_count *
+                                               (size_t(1) << header.log2m))
+        return nullptr;
+    // 半径少于预算允许的个数且未收敛时重新构建
+    if (!header.converged && header.hops < plan.hops)
+        return nullptr;
+
+    std::unique_ptr<KHopSketches> sketches(new KHopSketches());
+    sketches->header_ = header;
+    sketches->data_ = section.data() + sizeof(Header);
+    sketches->file_ = std::move(file);
+    return sketches;
+}
+
+void KHopSketches::Store(const std::string& path) const {
+    const uint8_t* begin = data_ - sizeof(Header);
+    size_t size = sizeof(Header) + header_.hops * header_.node_count *
+                                       (size_t(1) << header_.log2m);
+    hackathon::GraphFileWriter writer(path);
+    writer.AddSection(hackathon::GraphSection::kHopSketches, begin, size);
+    hackathon::GraphFileMeta meta;
+    meta.node_count = header_.node_count;
+    meta.edge_count = header_.edge_count;
+    writer.Finish(meta);
+}
+
+std::string KHopSketches::SidecarPath(const hackathon::GraphStorage& graph) {
+    std::string path = graph.GraphFilePath();
+    if (path.empty())
+        return path;
+    return std::filesystem::path(path).replace_filename(kSidecarName).string();
+}
+
+bool KHopSketches::Estimate(const hackathon::GraphStorage& graph,
+                            const k_hop_count& query,
+                            KHopEstimate* estimate) const {
+    if (!query.getLabels().empty() || !query.getEndLabel().empty())
+        return false;
+    int k = query.getLength();
+    if (k > int(header_.hops) && !Converged())
+        return false;
+
+    estimate->count = 0;
+    estimate->relative_error = RelativeError();
+    std::vector<uint32_t> sources;
+    for (const auto& item : query.getItems()) {
+        uint32_t id = graph.StringToId(item);
+        if (id != static_cast<uint32_t>(-1))
+            sources.push_back(id);
+    }
+    std::sort(sources.begin(), sources.end());
+    sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+    int radius = std::min<int>(k, header_.hops);
+    if (radius <= 0 || sources.empty())
+        return true;
+
+    size_t m = size_t(1) << header_.log2m;
+    std::vector<uint8_t> merged(m, 0);
+    for (uint32_t v : sources) {
+        mergeRegisters(merged.data(), Registers(radius, v), m);
+    }
+    // 球包含起点自身，起点个数是精确的
+    double count = estimateRegisters(merged.data(), m) - sources.size();
+    double limit = double(header_.node_count - sources.size());
+    estimate->count = std::llround(std::clamp(count, 0.0, limit));
+    return true;
+}
+
+double KHopSketches::RelativeError() const {
+    return 1.04 / std::sqrt(double(size_t(1) << header_.log2m));
+}
+
+KHopSketchJob::KHopSketchJob(const hackathon::GraphStorage& graph,
+                             const KHopSketchOptions& options)
+    : graph_(graph), options_(options) {}
+
+KHopSketchJob::~KHopSketchJob() { Wait(); }
+
+void KHopSketchJob::Start() {
+    thread_ = std::thread([this] { Run(); });
+}
+
+void KHopSketchJob::Wait() {
+    if (thread_.joinable())
+        thread_.join();
+}
+
+std::shared_ptr<const KHopSketches> KHopSketchJob::Current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+void KHopSketchJob::Run() {
+    // 只降低本线程；构建用的线程池在本线程创建，工作线程继承同样的 nice 值
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), kSketchNice);
+    try {
+        std::string path = KHopSketches::SidecarPath(graph_);
+        std::unique_ptr<KHopSketches> sketches;
+        sketches = KHopSketches::Open(path, graph_, options_);
+        if (!sketches) {
+            sketches = KHopSketches::Build(graph_, options_);
+            if (sketches && !path.empty()) {
+                sketches->Store(path);
+                // 换成文件映射，释放构建时的内存
+                if (auto mapped = KHopSketches::Open(path, graph_, options_))
+                    sketches = std::move(mapped);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_ = std::move(sketches);
+    } catch (const std::exception& e) {
+        std::cerr << "k-hop sketch job failed: " << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "graph_file.h"
+#include "graph_storage.h"
+#include "k_hop_count.h"
+
+struct KHopSketchOptions {
+    // 每个草图 2^log2m 个单字节寄存器，相对标准误差约 1.04 / sqrt(2^log2m)：
+    // 6 时约 13%，10 时约 3%。草图总大小为 顶点数 * 半径数 * 2^log2m 字节
+    uint32_t log2m = 6;
+    int max_hops = 4;  // 预计算的最大半径
+    // 草图总大小上限，超出时先减少半径数；一个半径也放不下时降低 log2m，
+    // 降到最小值 4 仍放不下则不构建
+    size_t memory_budget = size_t(1) << 30;
+    // 构建线程数，0 时取硬件线程数的 1/4，避免与查询争抢 CPU
+    unsigned threads = 0;
+};
+
+// 近似计数的结果
+struct KHopEstimate {
+    uint64_t count = 0;
+    double relative_error = 0;  // 相对标准误差
+};
+
+// 每个顶点在每个半径 t 上的出向球（t 跳内可达的顶点，含自身）的
+// HyperLogLog 草图，按 HyperANF 从 CSR 迭代得到：
+//   c_0(v) = {v}，c_t(v) = c_{t-1}(v) ∪ ⋃_{v->u} c_{t-1}(u)
+// 每轮对每个顶点把出邻居上一轮的寄存器逐字节取最大值。
+// 多起点查询把各起点的草图取并（寄存器取最大值）后估计，微秒级完成。
+// 存储在图容器旁的独立容器（SidecarPath）的 kHopSketches 段：头部之后按
+// 半径 1..hops 依次存放 顶点数 * 2^log2m 字节的寄存器，打开时直接映射。
+// 不改写图容器本身，头部记录图容器的 CRC 以识别重建后过期的草图。
+class KHopSketches {
+   public:
+    // 在 graph 上计算，精度和半径数按 memory_budget 缩减（输出原因）。
+    // 最小精度的一个半径也放不下时返回空
+    static std::unique_ptr<KHopSketches> Build(
+        const hackathon::GraphStorage& graph, const KHopSketchOptions& options);
+    // 从草图容器映射。文件不存在或损坏、与 graph 不匹配、或与按 options
+    // 构建的精度和半径数不同时返回空
+    static std::unique_ptr<KHopSketches> Open(
+        const std::string& path, const hackathon::GraphStorage& graph,
+        const KHopSketchOptions& options);
+
+    // 经临时文件写入草图容器后原子地改名，已映射旧文件的读者不受影响
+    void Store(const std::string& path) const;
+
+    // graph 对应的草图容器路径；旧的散文件目录返回空串
+    static std::string SidecarPath(const hackathon::GraphStorage& graph);
+
+    // 无边标签和终点标签、且 k 不超过已算的半径（或迭代已收敛）时给出
+    // 不含起点的近似顶点数，否则返回 false，由调用方精确计算
+    bool Estimate(const hackathon::GraphStorage& graph,
+                  const k_hop_count& query, KHopEstimate* estimate) const;
+
+    int Hops() const { return header_.hops; }
+
+    bool Converged() const { return header_.converged != 0; }
+
+    bool Mapped() const { return file_ != nullptr; }
+
+    double RelativeError() const;
+
+   private:
+    struct Header {
+        char magic[8];
+        uint32_t log2m;
+        uint32_t hops;
+        uint64_t node_count;
+        uint64_t edge_count;
+        uint32_t converged;  // hops 之后各半径的草图不再变化
+        uint32_t graph_checksum;  // 构建时图容器的头部 CRC
+    };
+
+    KHopSketches() = default;
+
+    // 半径 hops 上顶点 v 的寄存器
+    const uint8_t* Registers(int hops, uint32_t v) const {
+        return data_ + ((size_t(hops) - 1) * header_.node_count + v) *
+                           (size_t(1) << header_.log2m);
+    }
+
+    Header header_{};
+    const uint8_t* data_ = nullptr;
+    std::vector<uint8_t> owned_;  // Build 得到的草图，Open 时为空
+    std::unique_ptr<hackathon::GraphFile> file_;
+};
+
+// 后台构建草图：先尝试映射已有的草图容器，没有或不匹配时在后台线程以较低
+// 优先级、options.threads 个线程构建，写入草图容器后重新映射（旧的散文件
+// 目录只保留在内存中）。完成前 Current 返回空，查询应回退到精确计算。
+// 任务运行期间不能重建 graph。
+class KHopSketchJob {
+   public:
+    KHopSketchJob(const hackathon::GraphStorage& graph,
+                  const KHopSketchOptions& options = {});
+    ~KHopSketchJob();
+
+    KHopSketchJob(const KHopSketchJob&) = delete;
+    KHopSketchJob& operator=(const KHopSketchJob&) = delete;
+
+    void Start();
+    void Wait();
+
+    std::shared_ptr<const KHopSketches> Current() const;
+
+   private:
+    void Run();
+
+    const hackathon::GraphStorage& graph_;
+    KHopSketchOptions options_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<const KHopSketches> current_;
+};
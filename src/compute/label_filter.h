@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "graph_storage.h"
+
+// 允许的边标签 ID，空表示不过滤
+using EdgeLabels = std::vector<uint16_t>;
+
+inline bool allows(const EdgeLabels& labels, uint16_t label) {
+    return std::find(labels.begin(), labels.end(), label) != labels.end();
+}
+
+// 允许标签下的邻居数，labels 为空时为全部邻居数
+inline uint64_t allowedDegree(
+    std::span<const hackathon::LabelSegment> segments,
+    const EdgeLabels& labels) {
+    uint64_t degree = 0;
+    for (const auto& segment : segments) {
+        if (labels.empty() || allows(labels, segment.label))
+            degree += segment.count;
+    }
+    return degree;
+}
+
+// 按允许的标签段依次对第 [first, last) 个邻居调用 fn，其余段不解码，
+// labels 为空时遍历所有段。每段从自己的恢复点解码，first 之前的整段直接跳过。
+// fn 返回 false 时提前结束并返回 false。
+template <typename Fn>
+bool forEachAllowed(const hackathon::NeighborRange& neighbors,
+                    std::span<const hackathon::LabelSegment> segments,
+                    const EdgeLabels& labels, size_t first, size_t last,
+                    Fn&& fn) {
+    size_t index = 0;
+    for (const auto& segment : segments) {
+        if (index >= last)
+            break;
+        if (!labels.empty() && !allows(labels, segment.label))
+            continue;
+        size_t from = first > index ? first - index : 0;
+        size_t to = std::min<size_t>(segment.count, last - index);
+        if (from < to && !neighbors.ForEachInSegment(segment, from, to, fn))
+            return false;
+        index += segment.count;
+    }
+    return true;
+}
+
+// 把查询的边标签名和终点标签名解析为 ID，图中不存在的边标签忽略。
+// 给了标签却都不存在时查询结果必为 0，返回 false。
+// 图没有标签数据时无法判断，抛出异常而不是返回 0
+inline bool resolveLabels(const hackathon::GraphStorage& graph,
+                          const std::vector<std::string>& edge_names,
+                          const std::string& end_name, EdgeLabels& labels,
+                          uint16_t& end_label) {
+    if ((!edge_names.empty() || !end_name.empty()) && !graph.HasLabels())
+        throw std::runtime_error(
+            "Graph has no label data, rebuild it to filter by labels");
+    labels.clear();
+    for (const auto& name : edge_names) {
+        uint16_t id = graph.EdgeLabelId(name);
+        if (id != hackathon::GraphStorage::kNoLabel && !allows(labels, id))
+            labels.push_back(id);
+    }
+    std::sort(labels.begin(), labels.end());
+    if (!edge_names.empty() && labels.empty())
+        return false;
+    end_label = hackathon::GraphStorage::kNoLabel;
+    if (!end_name.empty()) {
+        end_label = graph.VertexLabelId(end_name);
+        if (end_label == hackathon::GraphStorage::kNoLabel)
+            return false;
+    }
+    return true;
+}
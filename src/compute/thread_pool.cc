@@ -0,0 +1,153 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <exception>
+
+namespace hackathon {
+
+struct WorkStealingPool::Job {
+    struct Range {
+        std::mutex mutex;
+        size_t lo = 0;
+        size_t hi = 0;
+    };
+
+    Job(const TaskFn& fn, unsigned participants, size_t task_count)
+        : fn(fn), ranges(participants), pending(task_count) {
+        for (unsigned p = 0; p < participants; ++p) {
+            ranges[p].lo = task_count * p / participants;
+            ranges[p].hi = task_count * (p + 1) / participants;
+        }
+    }
+
+    // 先取自己区间的头部，取空后轮流窃取其他区间的后一半
+    bool Take(unsigned participant, size_t& task) {
+        Range& own = ranges[participant];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (own.lo < own.hi) {
+                task = own.lo++;
+                return true;
+            }
+        }
+        for (size_t i = 1; i < ranges.size(); ++i) {
+            Range& victim = ranges[(participant + i) % ranges.size()];
+            size_t lo;
+            size_t hi;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.lo >= victim.hi)
+                    continue;
+                lo = victim.lo + (victim.hi - victim.lo) / 2;
+                hi = victim.hi;
+                victim.hi = lo;
+            }
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.lo = lo + 1;
+            own.hi = hi;
+            task = lo;
+            return true;
+        }
+        return false;
+    }
+
+    const TaskFn& fn;
+    std::vector<Range> ranges;
+    std::atomic<size_t> pending;
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    std::exception_ptr error;
+};
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    for (unsigned i = 1; i < threads; ++i) {
+        workers_.emplace_back(&WorkStealingPool::WorkerLoop, this, i - 1);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+WorkStealingPool& WorkStealingPool::Shared() {
+    static WorkStealingPool pool(
+        std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+void WorkStealingPool::RunTasks(Job& job, unsigned participant) {
+    size_t task;
+    while (job.Take(participant, task)) {
+        try {
+            job.fn(task, participant);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job.done_mutex);
+            if (!job.error)
+                job.error = std::current_exception();
+        }
+        if (--job.pending == 0) {
+            std::lock_guard<std::mutex> lock(job.done_mutex);
+            job.done_cv.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::WorkerLoop(unsigned index) {
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (stop_)
+                return;
+            job = jobs_.front();
+        }
+        RunTasks(*job, index + 1);
+
+        // 该任务已无可领取的部分，移出队列避免其他线程反复进入
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(jobs_.begin(), jobs_.end(), job);
+        if (it != jobs_.end())
+            jobs_.erase(it);
+    }
+}
+
+void WorkStealingPool::ParallelFor(size_t task_count, const TaskFn& fn) {
+    if (task_count == 0)
+        return;
+    if (workers_.empty() || task_count == 1) {
+        for (size_t i = 0; i < task_count; ++i) {
+            fn(i, 0);
+        }
+        return;
+    }
+
+    auto job = std::make_shared<Job>(fn, Concurrency(), task_count);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(job);
+    }
+    cv_.notify_all();
+
+    RunTasks(*job, 0);
+    {
+        std::unique_lock<std::mutex> lock(job->done_mutex);
+        job->done_cv.wait(lock, [&] { return job->pending == 0; });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(jobs_.begin(), jobs_.end(), job);
+        if (it != jobs_.end())
+            jobs_.erase(it);
+    }
+    if (job->error)
+        std::rethrow_exception(job->error);
+}
+
+}  // namespace hackathon
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hackathon {
+
+// 工作窃取线程池。
+// 每次 ParallelFor 把任务下标按区间均分给各参与者（工作线程 + 调用线程），
+// 参与者从自己区间的头部取任务，取空后从其他参与者区间的尾部窃取一半。
+// 多个查询可并发调用 ParallelFor，互不阻塞。
+class WorkStealingPool {
+   public:
+    // fn(task_index, participant)，participant < Concurrency()，
+    // 同一时刻同一 participant 只在一个线程上运行，可用于索引线程局部缓冲
+    using TaskFn = std::function<void(size_t task, unsigned participant)>;
+
+    explicit WorkStealingPool(unsigned threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned Concurrency() const { return workers_.size() + 1; }
+
+    // 执行 task_count 个任务，阻塞到全部完成；任务抛出的首个异常会重新抛出
+    void ParallelFor(size_t task_count, const TaskFn& fn);
+
+    // 进程共享的线程池，线程数为硬件线程数
+    static WorkStealingPool& Shared();
+
+   private:
+    struct Job;
+
+    void WorkerLoop(unsigned index);
+    static void RunTasks(Job& job, unsigned participant);
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Job>> jobs_;
+    bool stop_ = false;
+};
+
+}  // namespace hackathon
@@ -0,0 +1,300 @@
+#include "vertex_set.h"
+#include <algorithm>
+#include <iterator>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// roaring 转换时每批 addMany 的顶点数
+constexpr size_t kConvertBatch = 4096;
+
+#if defined(__AVX2__)
+// 每字节的置位数：低、高半字节分别查表后相加，再用 sad 横向累加到 4 个 64 位槽
+inline __m256i popcount256(__m256i v) {
+    const __m256i lookup =
+        _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                         1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                    _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+#endif
+
+}  // namespace
+
+DenseBitset::DenseBitset(uint32_t universe)
+    : words_((size_t(universe) + 511) / 512 * kWordsPerLine, 0),
+      universe_(universe) {}
+
+uint64_t DenseBitset::Count() const {
+    const uint64_t* words = words_.data();
+    size_t n = words_.size();
+    size_t i = 0;
+    uint64_t count = 0;
+#if defined(__AVX2__)
+    __m256i sum = _mm256_setzero_si256();
+    for (; i + 4 <= n; i += 4) {
+        sum = _mm256_add_epi64(
+            sum, popcount256(_mm256_load_si256(
+                     reinterpret_cast<const __m256i*>(words + i))));
+    }
+    count = _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) +
+            _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3);
+#endif
+    for (; i < n; ++i) {
+        count += __builtin_popcountll(words[i]);
+    }
+    return count;
+}
+
+void DenseBitset::AndNot(const DenseBitset& other) {
+    uint64_t* words = words_.data();
+    const uint64_t* mask = other.words_.data();
+    size_t n = std::min(words_.size(), other.words_.size());
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        auto* dst = reinterpret_cast<__m256i*>(words + i);
+        __m256i m =
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(mask + i));
+        _mm256_store_si256(dst, _mm256_andnot_si256(m, _mm256_load_si256(dst)));
+    }
+#endif
+    for (; i < n; ++i) {
+        words[i] &= ~mask[i];
+    }
+}
+
+void DenseBitset::Or(const DenseBitset& other) {
+    uint64_t* words = words_.data();
+    const uint64_t* bits = other.words_.data();
+    size_t n = std::min(words_.size(), other.words_.size());
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        auto* dst = reinterpret_cast<__m256i*>(words + i);
+        __m256i b =
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(bits + i));
+        _mm256_store_si256(dst, _mm256_or_si256(_mm256_load_si256(dst), b));
+    }
+#endif
+    for (; i < n; ++i) {
+        words[i] |= bits[i];
+    }
+}
+
+VertexSet VertexSet::FromSorted(std::vector<uint32_t> vertices) {
+    VertexSet set;
+    set.kind_ = Kind::kSparse;
+    set.sparse_ = std::move(vertices);
+    return set;
+}
+
+VertexSet VertexSet::FromRoaring(roaring::Roaring bitmap) {
+    VertexSet set;
+    set.kind_ = Kind::kRoaring;
+    set.roaring_ = std::move(bitmap);
+    return set;
+}
+
+VertexSet VertexSet::FromDense(DenseBitset bits) {
+    VertexSet set;
+    set.kind_ = Kind::kDense;
+    set.dense_ = std::move(bits);
+    return set;
+}
+
+VertexSet::Kind VertexSet::Choose(uint64_t size, uint32_t universe,
+                                  uint32_t dense_ratio, uint32_t sparse_ratio) {
+    if (sparse_ratio > 0 && size <= universe / sparse_ratio)
+        return Kind::kSparse;
+    if (dense_ratio > 0 && size >= universe / dense_ratio)
+        return Kind::kDense;
+    return Kind::kRoaring;
+}
+
+bool VertexSet::Empty() const {
+    switch (kind_) {
+        case Kind::kSparse:
+            return sparse_.empty();
+        case Kind::kRoaring:
+            return roaring_.isEmpty();
+        case Kind::kDense:
+            break;
+    }
+    const uint64_t* words = dense_.Data();
+    return std::all_of(words, words + dense_.Words(),
+                       [](uint64_t w) { return w == 0; });
+}
+
+uint64_t VertexSet::Size() const {
+    switch (kind_) {
+        case Kind::kSparse:
+            return sparse_.size();
+        case Kind::kRoaring:
+            return roaring_.cardinality();
+        case Kind::kDense:
+            break;
+    }
+    return dense_.Count();
+}
+
+bool VertexSet::Contains(uint32_t v) const {
+    switch (kind_) {
+        case Kind::kSparse:
+            return std::binary_search(sparse_.begin(), sparse_.end(), v);
+        case Kind::kRoaring:
+            return roaring_.contains(v);
+        case Kind::kDense:
+            break;
+    }
+    return v < dense_.Universe() && dense_.Test(v);
+}
+
+size_t VertexSet::Bytes() const {
+    switch (kind_) {
+        case Kind::kSparse:
+            return sparse_.size() * sizeof(uint32_t);
+        case Kind::kRoaring:
+            return roaring_.getSizeInBytes();
+        case Kind::kDense:
+            break;
+    }
+    return dense_.Words() * sizeof(uint64_t);
+}
+
+void VertexSet::Convert(Kind kind, uint32_t universe) {
+    if (kind == kind_)
+        return;
+    switch (kind) {
+        case Kind::kSparse: {
+            std::vector<uint32_t> vertices;
+            ToArray(vertices);
+            sparse_ = std::move(vertices);
+            break;
+        }
+        case Kind::kRoaring: {
+            roaring::Roaring bitmap;
+            if (kind_ == Kind::kSparse) {
+                bitmap.addMany(sparse_.size(), sparse_.data());
+            } else {
+                std::vector<uint32_t> batch;
+                batch.reserve(kConvertBatch);
+                dense_.ForEach([&](uint32_t v) {
+                    batch.push_back(v);
+                    if (batch.size() == kConvertBatch) {
+                        bitmap.addMany(batch.size(), batch.data());
+                        batch.clear();
+                    }
+                });
+                bitmap.addMany(batch.size(), batch.data());
+            }
+            roaring_ = std::move(bitmap);
+            break;
+        }
+        case Kind::kDense: {
+            DenseBitset bits(universe);
+            ForEach([&](uint32_t v) { bits.Set(v); });
+            dense_ = std::move(bits);
+            break;
+        }
+    }
+    // 释放旧表示占用的内存
+    if (kind_ == Kind::kSparse)
+        std::vector<uint32_t>().swap(sparse_);
+    else if (kind_ == Kind::kRoaring)
+        roaring_ = roaring::Roaring();
+    else
+        dense_ = DenseBitset();
+    kind_ = kind;
+}
+
+void VertexSet::Subtract(const VertexSet& other) {
+    switch (kind_) {
+        case Kind::kSparse:
+            std::erase_if(sparse_,
+                          [&](uint32_t v) { return other.Contains(v); });
+            break;
+        case Kind::kRoaring:
+            if (other.kind_ == Kind::kRoaring) {
+                roaring_ -= other.roaring_;
+            } else if (other.kind_ == Kind::kSparse) {
+                for (uint32_t v : other.sparse_) {
+                    roaring_.remove(v);
+                }
+            } else {
+                std::vector<uint32_t> kept;
+                for (uint32_t v : roaring_) {
+                    if (!other.Contains(v))
+                        kept.push_back(v);
+                }
+                roaring_ = roaring::Roaring();
+                roaring_.addMany(kept.size(), kept.data());
+            }
+            break;
+        case Kind::kDense:
+            if (other.kind_ == Kind::kDense) {
+                dense_.AndNot(other.dense_);
+            } else {
+                uint32_t universe = dense_.Universe();
+                other.ForEach([&](uint32_t v) {
+                    if (v < universe)
+                        dense_.Reset(v);
+                });
+            }
+            break;
+    }
+}
+
+void VertexSet::Unite(const VertexSet& other) {
+    if (other.kind_ == Kind::kDense) {
+        Convert(Kind::kDense, other.dense_.Universe());
+        dense_.Or(other.dense_);
+        return;
+    }
+    switch (kind_) {
+        case Kind::kSparse:
+            if (other.kind_ == Kind::kSparse) {
+                std::vector<uint32_t> merged;
+                merged.reserve(sparse_.size() + other.sparse_.size());
+                std::set_union(sparse_.begin(), sparse_.end(),
+                               other.sparse_.begin(), other.sparse_.end(),
+                               std::back_inserter(merged));
+                sparse_ = std::move(merged);
+                break;
+            }
+            Convert(Kind::kRoaring, 0);
+            roaring_ |= other.roaring_;
+            break;
+        case Kind::kRoaring:
+            if (other.kind_ == Kind::kRoaring)
+                roaring_ |= other.roaring_;
+            else
+                roaring_.addMany(other.sparse_.size(), other.sparse_.data());
+            break;
+        case Kind::kDense:
+            other.ForEach([&](uint32_t v) { dense_.Set(v); });
+            break;
+    }
+}
+
+void VertexSet::ToArray(std::vector<uint32_t>& out) const {
+    out.clear();
+    switch (kind_) {
+        case Kind::kSparse:
+            out = sparse_;
+            break;
+        case Kind::kRoaring:
+            out.resize(roaring_.cardinality());
+            roaring_.toUint32Array(out.data());
+            break;
+        case Kind::kDense:
+            dense_.ForEach([&](uint32_t v) { out.push_back(v); });
+            break;
+    }
+}
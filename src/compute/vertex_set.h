@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "roaring/roaring.hh"
+
+// 按缓存行对齐分配，平铺位图的 SIMD 循环用对齐读写
+template <typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+    static constexpr size_t kAlignment = 64;
+
+    CacheAlignedAllocator() = default;
+
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t(kAlignment)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(kAlignment));
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const {
+        return true;
+    }
+};
+
+// 平铺位图，每个顶点一位。字数补齐到整缓存行，超出 universe 的位恒为 0，
+// 计数和集合运算按 256 位整块处理，没有尾部分支
+class DenseBitset {
+   public:
+    static constexpr size_t kWordsPerLine = 8;
+
+    DenseBitset() = default;
+    explicit DenseBitset(uint32_t universe);
+
+    uint32_t Universe() const { return universe_; }
+
+    size_t Words() const { return words_.size(); }
+
+    const uint64_t* Data() const { return words_.data(); }
+
+    bool Test(uint32_t v) const { return (words_[v >> 6] >> (v & 63)) & 1; }
+
+    void Set(uint32_t v) { words_[v >> 6] |= uint64_t(1) << (v & 63); }
+
+    void Reset(uint32_t v) { words_[v >> 6] &= ~(uint64_t(1) << (v & 63)); }
+
+    // 多个线程可能写同一字时使用；已置位时不发原子操作
+    void AtomicSet(uint32_t v) {
+        uint64_t bit = uint64_t(1) << (v & 63);
+        std::atomic_ref<uint64_t> word(words_[v >> 6]);
+        if (!(word.load(std::memory_order_relaxed) & bit))
+            word.fetch_or(bit, std::memory_order_relaxed);
+    }
+
+    // 置位数，AVX2 下按字节查表求和（Mula 算法）
+    uint64_t Count() const;
+    // this &= ~other，两者 universe 相同
+    void AndNot(const DenseBitset& other);
+    // this |= other，两者 universe 相同
+    void Or(const DenseBitset& other);
+
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            uint64_t bits = words_[w];
+            while (bits) {
+                fn(uint32_t((w << 6) + __builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+   private:
+    std::vector<uint64_t, CacheAlignedAllocator<uint64_t>> words_;
+    uint32_t universe_ = 0;
+};
+
+// k 跳遍历中的顶点集合（frontier 与已访问集合），按密度在三种表示间切换：
+//   kSparse   有序无重复的数组，前几跳只有少量顶点，直接作为扩展的输入
+//   kRoaring  roaring bitmap，中等密度，内存随集合大小伸缩
+//   kDense    NodeCount 位的平铺位图，集合占顶点总数较大比例时使用，
+//             差集、并集和计数按 AVX2 整块处理，成员判断 O(1)
+// 表示由调用方按 Choose 的结果转换，运算对任意两种表示的组合都成立。
+class VertexSet {
+   public:
+    // 取值按密度递增，可比较大小
+    enum class Kind { kSparse, kRoaring, kDense };
+
+    VertexSet() = default;
+
+    static VertexSet FromSorted(std::vector<uint32_t> vertices);
+    static VertexSet FromRoaring(roaring::Roaring set);
+    static VertexSet FromDense(DenseBitset bits);
+
+    // 集合不超过 universe / sparse_ratio 时用数组，不少于
+    // universe / dense_ratio 时用平铺位图，其间用 roaring；比例为 0 表示不用该表示
+    static Kind Choose(uint64_t size, uint32_t universe, uint32_t dense_ratio,
+                       uint32_t sparse_ratio);
+
+    Kind GetKind() const { return kind_; }
+
+    bool Empty() const;
+    // 平铺位图时为 SIMD popcount，O(universe / 64)
+    uint64_t Size() const;
+    bool Contains(uint32_t v) const;
+    size_t Bytes() const;
+
+    // universe 只在转为 kDense 时使用
+    void Convert(Kind kind, uint32_t universe);
+
+    // this -= other；两者都是平铺位图时用 AVX2 and-not
+    void Subtract(const VertexSet& other);
+    // this |= other；other 为平铺位图时 this 也转为平铺位图
+    void Unite(const VertexSet& other);
+
+    // 按顶点 ID 升序
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        switch (kind_) {
+            case Kind::kSparse:
+                for (uint32_t v : sparse_) {
+                    fn(v);
+                }
+                break;
+            case Kind::kRoaring:
+                for (uint32_t v : roaring_) {
+                    fn(v);
+                }
+                break;
+            case Kind::kDense:
+                dense_.ForEach(fn);
+                break;
+        }
+    }
+
+    void ToArray(std::vector<uint32_t>& out) const;
+
+    const DenseBitset& Dense() const { return dense_; }
+
+   private:
+    Kind kind_ = Kind::kSparse;
+    std::vector<uint32_t> sparse_;
+    roaring::Roaring roaring_;
+    DenseBitset dense_;
+};
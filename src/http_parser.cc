@@ -0,0 +1,149 @@
+#include "http_parser.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i] >= 'A' && a[i] <= 'Z' ? a[i] + 32 : a[i];
+        char y = b[i] >= 'A' && b[i] <= 'Z' ? b[i] + 32 : b[i];
+        if (x != y)
+            return false;
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+}  // namespace
+
+HttpParser::Status HttpParser::Parse(std::string_view data, HttpRequest& req) {
+    while (state_ != State::kBody) {
+        size_t nl = data.find('\n', scan_);
+        if (nl == std::string_view::npos) {
+            scan_ = data.size();
+            return scan_ > kMaxHeaderBytes ? Status::kError
+                                           : Status::kIncomplete;
+        }
+        size_t line_begin = body_begin_;
+        std::string_view line = data.substr(line_begin, nl - line_begin);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        scan_ = body_begin_ = nl + 1;
+        if (body_begin_ > kMaxHeaderBytes)
+            return Status::kError;
+
+        if (state_ == State::kRequestLine) {
+            // 请求之间多余的空行忽略
+            if (line.empty())
+                continue;
+            if (!ParseRequestLine(line, line_begin))
+                return Status::kError;
+            state_ = State::kHeaders;
+        } else if (line.empty()) {
+            state_ = State::kBody;
+        } else if (!ParseHeader(line)) {
+            return Status::kError;
+        }
+    }
+
+    if (data.size() < body_begin_ + content_length_)
+        return Status::kIncomplete;
+    req.method = data.substr(method_begin_, method_len_);
+    req.path = data.substr(path_begin_, path_len_);
+    req.body = data.substr(body_begin_, content_length_);
+    req.keep_alive = keep_alive_;
+    return Status::kComplete;
+}
+
+// METHOD SP request-target SP HTTP-version
+bool HttpParser::ParseRequestLine(std::string_view line, size_t offset) {
+    size_t sp1 = line.find(' ');
+    if (sp1 == std::string_view::npos || sp1 == 0)
+        return false;
+    size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos || sp2 == sp1 + 1)
+        return false;
+    std::string_view version = line.substr(sp2 + 1);
+    if (version.substr(0, 7) != "HTTP/1.")
+        return false;
+
+    std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    method_begin_ = offset;
+    method_len_ = sp1;
+    path_begin_ = offset + sp1 + 1;
+    path_len_ = std::min(target.find('?'), target.size());
+    // HTTP/1.1 默认保持连接，1.0 需要显式 keep-alive
+    keep_alive_ = version == "HTTP/1.1";
+    return true;
+}
+
+bool HttpParser::ParseHeader(std::string_view line) {
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+        return false;
+    std::string_view name = line.substr(0, colon);
+    std::string_view value = trim(line.substr(colon + 1));
+
+    if (equalsIgnoreCase(name, "Content-Length")) {
+        if (value.empty())
+            return false;
+        size_t length = 0;
+        for (char c : value) {
+            if (c < '0' || c > '9')
+                return false;
+            length = length * 10 + (c - '0');
+            if (length > kMaxBodyBytes)
+                return false;
+        }
+        content_length_ = length;
+    } else if (equalsIgnoreCase(name, "Connection")) {
+        if (equalsIgnoreCase(value, "close"))
+            keep_alive_ = false;
+        else if (equalsIgnoreCase(value, "keep-alive"))
+            keep_alive_ = true;
+    } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+        return false;
+    }
+    return true;
+}
+
+RecvBuffer::RecvBuffer(size_t capacity)
+    : data_(new char[capacity]), capacity_(capacity) {}
+
+size_t RecvBuffer::Writable(size_t max_capacity) {
+    if (tail_ < capacity_)
+        return capacity_ - tail_;
+    if (head_ > 0) {
+        // 压缩：未处理的数据搬回开头
+        std::memmove(data_.get(), data_.get() + head_, tail_ - head_);
+        tail_ -= head_;
+        head_ = 0;
+        return capacity_ - tail_;
+    }
+    if (capacity_ >= max_capacity)
+        return 0;
+    size_t capacity = std::min(capacity_ * 2, max_capacity);
+    std::unique_ptr<char[]> data(new char[capacity]);
+    std::memcpy(data.get(), data_.get(), tail_);
+    data_ = std::move(data);
+    capacity_ = capacity;
+    return capacity_ - tail_;
+}
+
+void RecvBuffer::Consume(size_t n) {
+    head_ += n;
+    if (head_ == tail_)
+        head_ = tail_ = 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include <string_view>
+
+// 一个完整的 HTTP 请求，视图指向连接的接收缓冲，
+// 仅在处理函数执行期间有效
+struct HttpRequest {
+    std::string_view method;
+    std::string_view path;  // 不含查询串
+    std::string_view body;
+    bool keep_alive = true;
+};
+
+// 增量 HTTP/1.x 请求解析器。
+// 每次传入从当前请求起点开始的全部已收字节，解析器记住已扫描的位置，
+// 数据分多次到达时每个字节只扫描一次。状态只保存相对请求起点的偏移，
+// 调用之间缓冲可以整体搬移。只支持 Content-Length 正文，不支持 chunked。
+class HttpParser {
+   public:
+    enum class Status { kIncomplete, kComplete, kError };
+
+    static constexpr size_t kMaxHeaderBytes = 8192;
+    static constexpr size_t kMaxBodyBytes = 1 << 20;
+
+    // kComplete 时填写 req，视图指向 data
+    Status Parse(std::string_view data, HttpRequest& req);
+
+    // 已完成请求在 data 中占的字节数（kComplete 之后有效）
+    size_t RequestLength() const { return body_begin_ + content_length_; }
+
+    // 开始解析下一个请求
+    void Reset() { *this = HttpParser(); }
+
+   private:
+    enum class State { kRequestLine, kHeaders, kBody };
+
+    bool ParseRequestLine(std::string_view line, size_t offset);
+    bool ParseHeader(std::string_view line);
+
+    State state_ = State::kRequestLine;
+    size_t scan_ = 0;        // 下次查找换行的起点
+    size_t method_begin_ = 0;
+    size_t method_len_ = 0;
+    size_t path_begin_ = 0;
+    size_t path_len_ = 0;
+    size_t body_begin_ = 0;  // 头部解析中为下一行起点，空行后即正文起点
+    size_t content_length_ = 0;
+    bool keep_alive_ = true;
+};
+
+// 连接的接收缓冲：线性缓冲，数据写在 [head, tail)。
+// 写到末尾时把未处理的数据搬回开头（压缩），单个请求放不下时才扩容。
+// 搬移和扩容都会使视图失效，调用方保证有请求在执行时不再写入。
+class RecvBuffer {
+   public:
+    explicit RecvBuffer(size_t capacity = 16384);
+
+    std::string_view Data() const {
+        return std::string_view(data_.get() + head_, tail_ - head_);
+    }
+
+    // 可写入的空间，容量不超过 max_capacity；返回 0 表示缓冲已满
+    size_t Writable(size_t max_capacity);
+    char* WritePtr() { return data_.get() + tail_; }
+    void Commit(size_t n) { tail_ += n; }
+
+    // 丢弃开头 n 个已处理的字节
+    void Consume(size_t n);
+
+   private:
+    std::unique_ptr<char[]> data_;
+    size_t capacity_;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+};
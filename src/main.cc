@@ -1,10 +1,20 @@
 #include <iostream>
+#include "graph_storage.h"
+#include "query_handler.h"
 #include "server.h"
-#include "storage/graph_storage.h"
 
 int main(int argc, char* argv[]) {
+    // 启动时把图整体预热进内存，避免前几分钟的查询逐页缺页。
+    // 图随后会重建，预热只在重建完成后做一次
+    hackathon::LoadOptions load_options;
+    load_options.prefault = hackathon::Prefault::kParallel;
+    load_options.advise = true;
     hackathon::GraphStorage storage("graph_data");
+    storage.SetLoadOptions(load_options);
     storage.BuildFromCSV("data/sample.csv");
+    const auto& warmup = storage.Warmup();
+    std::cout << "Graph warm-up took " << warmup.seconds * 1000 << " ms ("
+              << (warmup.prefaulted_bytes >> 20) << " MB prefaulted)\n";
 
     // 示例用法
     uint32_t node_id = storage.StringToId("node1");
@@ -16,10 +26,36 @@ int main(int argc, char* argv[]) {
     if (argc > 1) {
         port = std::stoi(argv[1]);
     }
-    initBuf();
-    runServer(port);
+    // 可选：I/O 线程数、查询线程数（默认取硬件线程数）、访问日志抽样间隔
+    ServerOptions options;
+    options.reactors = argc > 2 ? std::stoul(argv[2]) : 0;
+    options.query_threads = argc > 3 ? std::stoul(argv[3]) : 0;
+    options.log_sample = argc > 4 ? std::stoul(argv[4]) : 0;
+    KHopCache cache;
+    // 近似计数用的草图在后台构建，完成前近似请求按精确计算。
+    // 可选：草图精度 log2m、草图内存上限（MB）
+    KHopSketchOptions sketch_options;
+    if (argc > 5)
+        sketch_options.log2m = std::stoul(argv[5]);
+    if (argc > 6)
+        sketch_options.memory_budget = size_t(std::stoull(argv[6])) << 20;
+    KHopSketchJob sketches(storage, sketch_options);
+    sketches.Start();
+    Router router;
+    router.Add("POST", "/khop", [&](const HttpRequest& req) {
+        return handleKHopRequest(storage, &cache, req.body, &sketches);
+    });
+    router.Add("POST", "/khop/batch", [&](const HttpRequest& req) {
+        return handleKHopBatchRequest(storage, &cache, req.body);
+    });
+    router.Add("POST", "/khop/reach", [&](const HttpRequest& req) {
+        return handleKHopReachRequest(storage, req.body);
+    });
+    router.Add("GET", "/stats/cache",
+               [&](const HttpRequest&) { return cacheStatsResponse(cache); });
+    runServer(port, router, options);
 
     return 0;
 }
 
-//  g++ -g *.cc   -o main
\ No newline at end of file
+//  g++ -g *.cc   -o main
@@ -0,0 +1,286 @@
+#include "query_handler.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "itoa.h"
+#include "k_hop_batch.h"
+
+namespace {
+
+// 只识别查询需要的 JSON 子集：字符串、非负整数和字符串数组
+class JsonScanner {
+   public:
+    explicit JsonScanner(std::string_view text) : text_(text) {}
+
+    // 定位到顶层对象中 key 对应的值，不存在返回 false
+    bool Seek(std::string_view key) {
+        std::string quoted = "\"" + std::string(key) + "\"";
+        size_t pos = text_.find(quoted);
+        while (pos != std::string_view::npos) {
+            pos_ = pos + quoted.size();
+            SkipSpace();
+            if (pos_ < text_.size() && text_[pos_] == ':') {
+                ++pos_;
+                SkipSpace();
+                return true;
+            }
+            pos = text_.find(quoted, pos + 1);
+        }
+        return false;
+    }
+
+    std::string String() {
+        Expect('"');
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c == '\\' && pos_ < text_.size())
+                c = text_[pos_++];
+            out.push_back(c);
+        }
+        Expect('"');
+        return out;
+    }
+
+    int64_t Integer() {
+        size_t begin = pos_;
+        int64_t value = 0;
+        while (pos_ < text_.size() && text_[pos_] >= '0' &&
+               text_[pos_] <= '9') {
+            value = value * 10 + (text_[pos_++] - '0');
+            if (value > INT32_MAX)
+                throw std::invalid_argument("integer out of range");
+        }
+        if (pos_ == begin)
+            throw std::invalid_argument("expected integer");
+        return value;
+    }
+
+    bool Boolean() {
+        for (std::string_view word : {"true", "false"}) {
+            if (text_.substr(pos_, word.size()) == word) {
+                pos_ += word.size();
+                return word == "true";
+            }
+        }
+        throw std::invalid_argument("expected boolean");
+    }
+
+    std::vector<std::string> StringArray() {
+        std::vector<std::string> out;
+        Expect('[');
+        SkipSpace();
+        if (Peek() == ']') {
+            ++pos_;
+            return out;
+        }
+        while (true) {
+            SkipSpace();
+            out.push_back(String());
+            SkipSpace();
+            if (Peek() == ']') {
+                ++pos_;
+                return out;
+            }
+            Expect(',');
+        }
+    }
+
+    // 对象数组，返回各对象的原始文本（含花括号），交给新的 JsonScanner 解析
+    std::vector<std::string_view> ObjectArray() {
+        std::vector<std::string_view> out;
+        Expect('[');
+        SkipSpace();
+        if (Peek() == ']') {
+            ++pos_;
+            return out;
+        }
+        while (true) {
+            SkipSpace();
+            out.push_back(Object());
+            SkipSpace();
+            if (Peek() == ']') {
+                ++pos_;
+                return out;
+            }
+            Expect(',');
+        }
+    }
+
+   private:
+    // 跳过一个对象，字符串内的括号不计
+    std::string_view Object() {
+        size_t begin = pos_;
+        Expect('{');
+        int depth = 1;
+        bool in_string = false;
+        while (pos_ < text_.size() && depth > 0) {
+            char c = text_[pos_++];
+            if (in_string) {
+                if (c == '\\')
+                    ++pos_;
+                else if (c == '"')
+                    in_string = false;
+            } else if (c == '"') {
+                in_string = true;
+            } else if (c == '{') {
+                ++depth;
+            } else if (c == '}') {
+                --depth;
+            }
+        }
+        if (depth > 0)
+            throw std::invalid_argument("unterminated object");
+        return text_.substr(begin, pos_ - begin);
+    }
+
+    char Peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+    void Expect(char c) {
+        if (Peek() != c)
+            throw std::invalid_argument(std::string("expected '") + c + "'");
+        ++pos_;
+    }
+
+    void SkipSpace() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' ||
+                text_[pos_] == '\r' || text_[pos_] == '\n')) {
+            ++pos_;
+        }
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+
+}  // namespace
+
+k_hop_count parseKHopRequest(std::string_view body) {
+    JsonScanner json(body);
+    k_hop_count query;
+    if (!json.Seek("items"))
+        throw std::invalid_argument("missing items");
+    query.setItems(json.StringArray());
+    if (!json.Seek("length"))
+        throw std::invalid_argument("missing length");
+    query.setLength(static_cast<int>(json.Integer()));
+    if (json.Seek("labels"))
+        query.setLabels(json.StringArray());
+    if (json.Seek("endLabel"))
+        query.setEndLabel(json.String());
+    return query;
+}
+
+std::vector<k_hop_count> parseKHopBatchRequest(std::string_view body) {
+    JsonScanner json(body);
+    if (!json.Seek("queries"))
+        throw std::invalid_argument("missing queries");
+    std::vector<k_hop_count> queries;
+    for (std::string_view object : json.ObjectArray()) {
+        queries.push_back(parseKHopRequest(object));
+    }
+    return queries;
+}
+
+std::string handleKHopRequest(const hackathon::GraphStorage& graph,
+                              KHopCache* cache, std::string_view body,
+                              const KHopSketchJob* sketches) {
+    k_hop_count query = parseKHopRequest(body);
+    JsonScanner json(body);
+    bool approximate = json.Seek("approximate") && json.Boolean();
+    if (approximate && sketches) {
+        auto current = sketches->Current();
+        KHopEstimate estimate;
+        if (current && current->Estimate(graph, query, &estimate)) {
+            return "{\"count\":" + std::to_string(estimate.count) +
+                   ",\"approximate\":true,\"error\":" +
+                   std::to_string(estimate.relative_error) + "}";
+        }
+    }
+
+    uint64_t count =
+        cache ? cache->Count(graph, query) : query.kHopCount(graph);
+    // 计数不超过顶点数，itoa 只支持到 32 位
+    char temp[16]{};
+    char* end = itoa_fwd(static_cast<uint32_t>(count), temp);
+    std::string response = "{\"count\":";
+    response.append(temp, end - temp);
+    // 要求近似但草图未就绪或查询不支持时，告知调用方结果是精确的
+    if (approximate)
+        response.append(",\"approximate\":false");
+    response.push_back('}');
+    return response;
+}
+
+std::string handleKHopBatchRequest(const hackathon::GraphStorage& graph,
+                                   KHopCache* cache, std::string_view body) {
+    std::vector<k_hop_count> queries = parseKHopBatchRequest(body);
+    std::vector<uint64_t> counts(queries.size());
+
+    // 命中缓存的直接取结果，其余合成一批共享遍历
+    std::vector<size_t> misses;
+    std::vector<k_hop_count> pending;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        if (!cache || !cache->Lookup(queries[i], counts[i])) {
+            misses.push_back(i);
+            pending.push_back(std::move(queries[i]));
+        }
+    }
+    std::vector<uint64_t> computed = kHopCountBatch(graph, pending);
+    for (size_t j = 0; j < misses.size(); ++j) {
+        counts[misses[j]] = computed[j];
+        if (cache)
+            cache->Store(pending[j], computed[j]);
+    }
+
+    std::string response = "{\"counts\":[";
+    char temp[16];
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (i > 0)
+            response.push_back(',');
+        char* end = itoa_fwd(static_cast<uint32_t>(counts[i]), temp);
+        response.append(temp, end - temp);
+    }
+    response.append("]}");
+    return response;
+}
+
+std::string handleKHopReachRequest(const hackathon::GraphStorage& graph,
+                                   std::string_view body) {
+    JsonScanner json(body);
+    if (!json.Seek("source"))
+        throw std::invalid_argument("missing source");
+    std::string source = json.String();
+    if (!json.Seek("target"))
+        throw std::invalid_argument("missing target");
+    std::string target = json.String();
+    if (!json.Seek("length"))
+        throw std::invalid_argument("missing length");
+    int length = static_cast<int>(json.Integer());
+    std::vector<std::string> labels;
+    if (json.Seek("labels"))
+        labels = json.StringArray();
+
+    KHopReach reach = kHopReach(graph, source, target, length, labels);
+    return std::string("{\"reachable\":") +
+           (reach.reachable ? "true" : "false") +
+           ",\"distance\":" + std::to_string(reach.distance) + "}";
+}
+
+std::string cacheStatsResponse(const KHopCache& cache) {
+    KHopCache::Stats stats = cache.GetStats();
+    uint64_t lookups = stats.hits + stats.misses;
+    std::string response = "{\"hits\":" + std::to_string(stats.hits) +
+                           ",\"misses\":" + std::to_string(stats.misses) +
+                           ",\"hitRate\":" +
+                           std::to_string(lookups ? double(stats.hits) / lookups
+                                                  : 0.0) +
+                           ",\"resumed\":" + std::to_string(stats.resumed) +
+                           ",\"resumedHops\":" +
+                           std::to_string(stats.resumed_hops) +
+                           ",\"evictions\":" + std::to_string(stats.evictions) +
+                           ",\"entries\":" + std::to_string(stats.entries) +
+                           ",\"bytes\":" + std::to_string(stats.bytes) + "}";
+    return response;
+}
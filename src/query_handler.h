@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "graph_storage.h"
+#include "k_hop_cache.h"
+#include "k_hop_count.h"
+#include "k_hop_reach.h"
+#include "k_hop_sketch.h"
+
+// 解析 k 跳查询的 JSON 请求体：
+// {"items": ["a", "b"], "length": 3, "labels": ["knows"], "endLabel": "P"}
+// labels、endLabel 可省略；格式错误时抛出 std::invalid_argument
+k_hop_count parseKHopRequest(std::string_view body);
+
+// 解析请求体并在 graph 上执行 k 跳计数，返回 {"count":N}；
+// cache 非空时先查缓存。请求带 "approximate": true 且草图可用时用草图估计，
+// 返回 {"count":N,"approximate":true,"error":相对标准误差}；
+// 草图不可用时精确计算并附带 "approximate":false
+std::string handleKHopRequest(const hackathon::GraphStorage& graph,
+                              KHopCache* cache, std::string_view body,
+                              const KHopSketchJob* sketches = nullptr);
+
+// 批量请求：{"queries": [{...}, {...}]}，每个元素同 parseKHopRequest
+std::vector<k_hop_count> parseKHopBatchRequest(std::string_view body);
+
+// 批量执行，共享遍历，返回 {"counts":[...]}，顺序与请求一致
+std::string handleKHopBatchRequest(const hackathon::GraphStorage& graph,
+                                   KHopCache* cache, std::string_view body);
+
+// 点到点可达查询：{"source": "a", "target": "b", "length": 3,
+// "labels": ["knows"]}，labels 可省略。返回 {"reachable":true,"distance":2}，
+// 不可达时 distance 为 -1；格式错误时抛出 std::invalid_argument
+std::string handleKHopReachRequest(const hackathon::GraphStorage& graph,
+                                   std::string_view body);
+
+// 缓存命中率等计数，JSON 格式
+std::string cacheStatsResponse(const KHopCache& cache);
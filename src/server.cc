@@ -1,136 +1,611 @@
 #include "server.h"
-#include <assert.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
 #include <cstring>
+#include <deque>
 #include <iostream>
-#include <sstream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include "itoa.h"
 
-// 简单的 HTTP 请求解析结构
-struct HttpRequest {
-    // std::string_view method;
-    // int method_;
-    std::string_view path;
-    std::string_view body;
+namespace {
+
+constexpr int kMaxEvents = 256;
+// 接收缓冲上限，需放得下一个最大的请求
+constexpr size_t kMaxRequestBytes =
+    HttpParser::kMaxHeaderBytes + HttpParser::kMaxBodyBytes;
+// 每个连接同时执行的流水线请求数上限
+constexpr size_t kMaxPipeline = 64;
+// epoll data 中的保留 ID，连接从 kFirstConnId 开始编号
+constexpr uint64_t kListenId = 0;
+constexpr uint64_t kWakeId = 1;
+constexpr uint64_t kFirstConnId = 2;
+// 连接登记的事件，边沿触发
+constexpr uint32_t kConnEvents = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+
+// 单次 sendmsg 最多携带的 iovec 数，每个响应占 3 个
+constexpr size_t kMaxIov = 48;
+
+// 预先拼好的响应头，只差 Content-Length 的数字
+std::string_view headerTemplate(int status) {
+    switch (status) {
+        case 200:
+            return "HTTP/1.1 200 OK\r\n"
+                   "Content-Type: application/json\r\nContent-Length: ";
+        case 404:
+            return "HTTP/1.1 404 Not Found\r\n"
+                   "Content-Type: application/json\r\nContent-Length: ";
+        default:
+            return "HTTP/1.1 400 Bad Request\r\n"
+                   "Content-Type: application/json\r\nContent-Length: ";
+    }
+}
+
+// 异步抽样访问日志：I/O 线程每 sample 个响应记一条，放入有界队列后立即返回，
+// 后台线程批量写 stdout；队列满时丢弃。sample 为 0 时关闭。
+class AccessLog {
+   public:
+    explicit AccessLog(uint32_t sample) : sample_(sample) {
+        if (sample_ > 0)
+            thread_ = std::thread(&AccessLog::Loop, this);
+    }
+
+    ~AccessLog() {
+        if (!thread_.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    // 每个 I/O 线程独立计数，不共享缓存行
+    bool Sampled() const {
+        thread_local uint32_t counter = 0;
+        return sample_ > 0 && ++counter % sample_ == 0;
+    }
+
+    void Record(int status, std::string_view body) {
+        std::string line = std::to_string(status);
+        line.push_back(' ');
+        line.append(body.substr(0, kMaxBodyLogged));
+        line.push_back('\n');
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (lines_.size() >= kMaxQueued)
+                return;
+            lines_.push_back(std::move(line));
+        }
+        cv_.notify_one();
+    }
+
+   private:
+    static constexpr size_t kMaxQueued = 4096;
+    static constexpr size_t kMaxBodyLogged = 256;
+
+    void Loop() {
+        std::vector<std::string> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !lines_.empty(); });
+                if (lines_.empty())
+                    return;
+                batch.swap(lines_);
+            }
+            for (const auto& line : batch) {
+                fwrite(line.data(), 1, line.size(), stdout);
+            }
+            fflush(stdout);
+            batch.clear();
+        }
+    }
+
+    uint32_t sample_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::string> lines_;
+    bool stop_ = false;
 };
 
-constexpr int a = 10;
+// 查询线程池：I/O 线程投递任务，查询线程按到达顺序执行
+class QueryExecutor {
+   public:
+    explicit QueryExecutor(unsigned threads) {
+        for (unsigned i = 0; i < threads; ++i) {
+            threads_.emplace_back(&QueryExecutor::Loop, this);
+        }
+    }
 
-char resbuf[128];
+    ~QueryExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
 
-int len;
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
 
-void initBuf() {
-    char* format =
-        "HTTP/1.1 200 OK\r\nContent-Type: "
-        "application/json\r\n\r\n{\"count\":";
-    int lg = 0;
-    while (format[lg++])
-        ;
-    memcpy(resbuf, format, lg);
-    len = lg - 1;
-}
+   private:
+    void Loop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
 
-// 简易 HTTP 请求解析器（仅处理单次 recv 的完整请求）
-HttpRequest parseHttpRequest(const std::string_view raw) {
-    HttpRequest req;
-    auto end = raw.find(" ");
-    req.path = raw.substr(0, end);
-    auto start = end + 11;
-    auto dataIndex = raw.substr(start).find("\r\n\r\n");  // " HTTP/1.1\r\n"
-    req.body = raw.substr(start + dataIndex);
-    return req;
-}
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_ = false;
+};
 
-int makeResponse(int count) {
-    char temp[8]{};
-    itoa_fwd(count, temp);
-    int lg = 0;
-    while (temp[lg++])
-        ;
-    memcpy(resbuf + len, temp, lg - 1);
-    resbuf[len + lg - 1] = '}';
+// 流水线中一个请求的响应，按请求顺序发送。
+// 发送时由头模板、length 和 body 三段拼成 iovec，不再拷贝成整块
+struct Response {
+    bool done = false;
+    int status = 200;
+    std::string body;
+    char length[16];  // Content-Length 数字和结尾空行
+    uint8_t length_len = 0;
 
-    return len + lg - 1;
-}
+    void Set(int code, std::string text) {
+        status = code;
+        body = std::move(text);
+        char* end = itoa_fwd(static_cast<uint32_t>(body.size()), length);
+        std::memcpy(end, "\r\n\r\n", 4);
+        length_len = end + 4 - length;
+        done = true;
+    }
 
-// 处理单个请求
-int handleRequest(const HttpRequest& req) {
-    //TODO
-    return makeResponse(11);
-}
+    size_t Size() const {
+        return headerTemplate(status).size() + length_len + body.size();
+    }
+};
 
-// 主服务器循环
-void runServer(int port) {
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd == -1) {
-        perror("socket");
-        return;
+struct Connection {
+    int fd = -1;
+    RecvBuffer in;
+    HttpParser parser;       // 正在解析的请求，起点为 in 的 parsed 处
+    size_t parsed = 0;       // in 中已切出并分发的请求字节数
+    uint64_t first_seq = 0;  // pending 首个元素的请求序号
+    std::deque<Response> pending;  // 执行中或已完成未发完的响应
+    size_t executing = 0;    // pending 中尚未完成的请求数
+    size_t front_sent = 0;   // pending 队首已发送的字节数
+    bool keep_alive = true;  // 为 false 时不再接收新请求，发完响应后关闭
+    bool closing = false;    // 出错或对端已关闭
+};
+
+// 一个 I/O 线程：独立的监听 socket（SO_REUSEPORT 由内核分发连接）、
+// epoll 实例和连接表。查询在 QueryExecutor 上执行，结果经 eventfd 送回。
+// 一个连接上流水线的多个请求并发执行，响应按请求顺序发送；
+// 有请求在执行时接收缓冲不被写入，请求中的 string_view 因而一直有效。
+class Reactor {
+   public:
+    Reactor(const Router& router, QueryExecutor& executor, AccessLog& log)
+        : router_(router), executor_(executor), log_(log) {}
+
+    ~Reactor() {
+        for (auto& [id, conn] : conns_) {
+            close(conn.fd);
+        }
+        if (listen_fd_ != -1)
+            close(listen_fd_);
+        if (wake_fd_ != -1)
+            close(wake_fd_);
+        if (epoll_fd_ != -1)
+            close(epoll_fd_);
     }
 
-    // 允许端口复用
-    int opt = 1;
-    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    bool Listen(int port) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (listen_fd_ == -1) {
+            perror("socket");
+            return false;
+        }
+
+        // 允许端口复用，多个 reactor 各自 bind 同一端口
+        int opt = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+
+        struct sockaddr_in address;
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = INADDR_ANY;
+        address.sin_port = htons(port);
 
-    struct sockaddr_in address;
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port);
+        if (bind(listen_fd_, (struct sockaddr*)&address, sizeof(address)) <
+            0) {
+            perror("bind");
+            return false;
+        }
+        if (listen(listen_fd_, SOMAXCONN) < 0) {
+            perror("listen");
+            return false;
+        }
 
-    if (bind(server_fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-        perror("bind");
-        close(server_fd);
-        return;
+        epoll_fd_ = epoll_create1(0);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK);
+        if (epoll_fd_ == -1 || wake_fd_ == -1) {
+            perror("epoll");
+            return false;
+        }
+        return Watch(listen_fd_, kListenId, EPOLLIN | EPOLLET) &&
+               Watch(wake_fd_, kWakeId, EPOLLIN | EPOLLET);
     }
 
-    if (listen(server_fd, 5) < 0) {
-        perror("listen");
-        close(server_fd);
-        return;
+    void Run() {
+        struct epoll_event events[kMaxEvents];
+        while (true) {
+            int n = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                perror("epoll_wait");
+                return;
+            }
+            for (int i = 0; i < n; ++i) {
+                uint64_t id = events[i].data.u64;
+                if (id == kListenId) {
+                    Accept();
+                } else if (id == kWakeId) {
+                    DrainCompleted();
+                } else {
+                    OnEvent(id, events[i].events);
+                }
+            }
+        }
     }
 
-    std::cout << "HTTP server listening on port " << port << " ...\n";
+   private:
+    // 查询线程送回的结果
+    struct Done {
+        uint64_t id;
+        uint64_t seq;
+        int status;
+        std::string body;
+    };
+
+    bool Watch(int fd, uint64_t id, uint32_t events) {
+        struct epoll_event ev {};
+        ev.events = events;
+        ev.data.u64 = id;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            perror("epoll_ctl");
+            return false;
+        }
+        return true;
+    }
 
-    while (true) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_fd =
-            accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
-        if (client_fd < 0) {
-            perror("accept");
-            continue;
+    // 重新登记连接的事件。边沿触发下 EPOLL_CTL_MOD 会按当前状态重新报告，
+    // 发送缓冲此时已有空间也会收到一次 EPOLLOUT
+    void Rearm(uint64_t id, Connection& conn) {
+        struct epoll_event ev {};
+        ev.events = kConnEvents;
+        ev.data.u64 = id;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev) == -1) {
+            perror("epoll_ctl");
+            conn.closing = true;
         }
+    }
 
-        // 接收请求（简单：一次 recv，假设请求完整）
-        char buffer[1024];
-        ssize_t bytes = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-        if (bytes <= 0) {
-            close(client_fd);
-            continue;
+    void Accept() {
+        while (true) {
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    perror("accept");
+                return;
+            }
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            uint64_t id = next_id_++;
+            if (!Watch(fd, id, kConnEvents)) {
+                close(fd);
+                continue;
+            }
+            conns_[id].fd = fd;
         }
-        buffer[bytes] = '\0';
+    }
 
-        std::string_view requestStr(buffer + 5, buffer + bytes);  //POST离开
-        HttpRequest req = parseHttpRequest(requestStr);
-        auto responseLen = handleRequest(req);
-        // resbuf[responseLen + 1] = '\0';
-        // std::cout << responseLen << resbuf[responseLen]
-        //           << resbuf[responseLen - 1] << resbuf[responseLen - 2]
-        //           << resbuf[responseLen - 2] << std::endl;
+    void OnEvent(uint64_t id, uint32_t events) {
+        auto it = conns_.find(id);
+        if (it == conns_.end())
+            return;
+        Connection& conn = it->second;
+        if (events & (EPOLLERR | EPOLLHUP))
+            conn.closing = true;
+        if ((events & EPOLLOUT) && !conn.closing)
+            Flush(conn);
+        // 有请求在执行时接收缓冲不能移动，查询全部结束后再读。
+        // 流水线满时读取会暂停，响应发出后（EPOLLOUT）也要继续读
+        if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLOUT)) &&
+            conn.executing == 0)
+            ReadMore(id, conn);
+        MaybeClose(id, conn);
+    }
 
-        std::cout << responseLen << (char*)resbuf << std::endl;
+    // 没有请求在执行时：丢弃已处理的字节，先处理缓冲里剩下的流水线请求，
+    // 都处理完再从 socket 读取。缓冲读满时先解析分发再继续读，
+    // 多个小请求合计超过缓冲上限时不会被当成单个超长请求。
+    // 有请求开始执行或流水线已满时停止读取，等响应发出后再从这里继续
+    void ReadMore(uint64_t id, Connection& conn) {
+        bool full = true;
+        while (true) {
+            conn.in.Consume(conn.parsed);
+            conn.parsed = 0;
+            ParseRequests(id, conn);
+            if (!full || conn.executing > 0 || conn.closing ||
+                conn.pending.size() >= kMaxPipeline)
+                return;
+            full = Receive(conn);
+        }
+    }
 
-        // 发送响应
-        send(client_fd, resbuf, responseLen + 1, 0);
-        close(client_fd);
+    // 读到 EAGAIN 或缓冲满为止，本次读满缓冲时返回 true，由调用方先解析。
+    // 一开始就没有空间说明解析后缓冲里仍没有完整请求，即单个请求超过上限；
+    // 对端关闭写方向后处理完已收到的请求再断开
+    bool Receive(Connection& conn) {
+        bool received = false;
+        while (!conn.closing && conn.keep_alive) {
+            size_t space = conn.in.Writable(kMaxRequestBytes);
+            if (space == 0) {
+                if (received)
+                    return true;
+                conn.closing = true;
+                return false;
+            }
+            ssize_t n = recv(conn.fd, conn.in.WritePtr(), space, 0);
+            if (n > 0) {
+                conn.in.Commit(n);
+                received = true;
+                continue;
+            }
+            if (n == 0) {
+                conn.keep_alive = false;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                conn.closing = true;
+            }
+            return false;
+        }
+        return false;
     }
 
-    close(server_fd);
-}
+    // 从已收数据中切出所有完整请求（流水线），按序号分发到查询线程。
+    // 解析器从上次停下的位置继续，不重复扫描。
+    void ParseRequests(uint64_t id, Connection& conn) {
+        std::string_view data = conn.in.Data();
+        while (!conn.closing && conn.pending.size() < kMaxPipeline) {
+            HttpRequest req;
+            auto status = conn.parser.Parse(data.substr(conn.parsed), req);
+            if (status == HttpParser::Status::kIncomplete)
+                break;
+            uint64_t seq = conn.first_seq + conn.pending.size();
+            conn.pending.emplace_back();
+            if (status == HttpParser::Status::kError) {
+                Finish(conn, seq, 400, "{\"error\":\"bad request\"}");
+                conn.keep_alive = false;
+                break;
+            }
+            conn.parsed += conn.parser.RequestLength();
+            conn.parser.Reset();
+            const RequestHandler* handler = router_.Find(req.method, req.path);
+            if (!handler) {
+                Finish(conn, seq, 404, "{\"error\":\"not found\"}");
+            } else {
+                conn.executing++;
+                Dispatch(id, seq, *handler, req);
+            }
+            if (!req.keep_alive) {
+                conn.keep_alive = false;
+                break;
+            }
+        }
+        Flush(conn);
+    }
+
+    void Dispatch(uint64_t id, uint64_t seq, const RequestHandler& handler,
+                  const HttpRequest& req) {
+        executor_.Submit([this, id, seq, &handler, req] {
+            Done done{id, seq, 200, {}};
+            try {
+                done.body = handler(req);
+            } catch (const std::exception&) {
+                done.status = 400;
+                done.body = "{\"error\":\"bad request\"}";
+            }
+            Complete(std::move(done));
+        });
+    }
+
+    // 查询线程调用：登记结果并唤醒 I/O 线程
+    void Complete(Done done) {
+        {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            done_.push_back(std::move(done));
+        }
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    void DrainCompleted() {
+        uint64_t value;
+        while (read(wake_fd_, &value, sizeof(value)) > 0) {
+        }
+        std::vector<Done> done;
+        {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            done.swap(done_);
+        }
+        for (auto& [id, seq, status, body] : done) {
+            auto it = conns_.find(id);
+            if (it == conns_.end())
+                continue;
+            Connection& conn = it->second;
+            conn.executing--;
+            Finish(conn, seq, status, std::move(body));
+            Flush(conn);
+            // 执行期间到达的数据没有读取，边沿触发不会再通知
+            if (conn.executing == 0 && !conn.closing)
+                ReadMore(id, conn);
+            // 还有已完成的响应没发完：EPOLLOUT 的边沿可能在响应完成前
+            // 就已报告过，重新登记以保证发送缓冲有空间时再收到通知
+            if (!conn.closing && !conn.pending.empty() &&
+                conn.pending.front().done)
+                Rearm(id, conn);
+            MaybeClose(id, conn);
+        }
+    }
+
+    void Finish(Connection& conn, uint64_t seq, int status,
+                std::string body) {
+        if (log_.Sampled())
+            log_.Record(status, body);
+        conn.pending[seq - conn.first_seq].Set(status, std::move(body));
+    }
+
+    // 队首连续已完成的响应用一次 sendmsg 批量发出，流水线的多个响应合并为
+    // 一个系统调用；部分发送时记住队首已发字节数，等 EPOLLOUT 继续
+    void Flush(Connection& conn) {
+        while (!conn.closing && !conn.pending.empty() &&
+               conn.pending.front().done) {
+            struct iovec iov[kMaxIov];
+            size_t count = 0;
+            size_t skip = conn.front_sent;
+            for (const auto& response : conn.pending) {
+                if (!response.done || count + 3 > kMaxIov)
+                    break;
+                std::string_view parts[3] = {
+                    headerTemplate(response.status),
+                    std::string_view(response.length, response.length_len),
+                    response.body};
+                for (auto part : parts) {
+                    if (skip >= part.size()) {
+                        skip -= part.size();
+                        continue;
+                    }
+                    iov[count].iov_base = const_cast<char*>(part.data() + skip);
+                    iov[count].iov_len = part.size() - skip;
+                    count++;
+                    skip = 0;
+                }
+            }
+
+            struct msghdr msg {};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = count;
+            ssize_t n = sendmsg(conn.fd, &msg, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    conn.closing = true;
+                return;
+            }
+
+            size_t sent = conn.front_sent + n;
+            while (!conn.pending.empty() && conn.pending.front().done &&
+                   sent >= conn.pending.front().Size()) {
+                sent -= conn.pending.front().Size();
+                conn.pending.pop_front();
+                conn.first_seq++;
+            }
+            conn.front_sent = sent;
+            if (sent > 0)
+                return;  // 发送缓冲已满
+        }
+    }
+
+    // 出错的连接等查询结束后释放；不再保持的连接发完响应后关闭
+    void MaybeClose(uint64_t id, Connection& conn) {
+        if (conn.closing ? conn.executing == 0
+                         : conn.pending.empty() && !conn.keep_alive)
+            Close(id, conn);
+    }
+
+    void Close(uint64_t id, Connection& conn) {
+        close(conn.fd);
+        conns_.erase(id);
+    }
 
-// ===== 主函数 =====
\ No newline at end of file
+    const Router& router_;
+    QueryExecutor& executor_;
+    AccessLog& log_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    uint64_t next_id_ = kFirstConnId;
+    std::unordered_map<uint64_t, Connection> conns_;
+    std::mutex done_mutex_;
+    std::vector<Done> done_;
+};
+
+}  // namespace
+
+// 主服务器循环
+void runServer(int port, const Router& router, const ServerOptions& options) {
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    unsigned reactors = options.reactors ? options.reactors : hardware;
+    unsigned query_threads =
+        options.query_threads ? options.query_threads : hardware;
+
+    AccessLog log(options.log_sample);
+    QueryExecutor executor(query_threads);
+    std::vector<std::unique_ptr<Reactor>> loops;
+    for (unsigned i = 0; i < reactors; ++i) {
+        auto reactor = std::make_unique<Reactor>(router, executor, log);
+        if (!reactor->Listen(port))
+            return;
+        loops.push_back(std::move(reactor));
+    }
+
+    std::cout << "HTTP server listening on port " << port << " with "
+              << reactors << " reactors ...\n";
+
+    std::vector<std::thread> threads;
+    for (auto& reactor : loops) {
+        threads.emplace_back(&Reactor::Run, reactor.get());
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
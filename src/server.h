@@ -1,2 +1,52 @@
-void initBuf(void);
-void runServer(int);
\ No newline at end of file
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "http_parser.h"
+
+// 请求处理函数，在查询线程上执行，返回 JSON 响应体；
+// 抛出异常时返回 400
+using RequestHandler = std::function<std::string(const HttpRequest&)>;
+
+// 方法 + 路径到处理函数的路由表，路由数很少，按注册顺序线性匹配
+class Router {
+   public:
+    void Add(std::string method, std::string path, RequestHandler handler) {
+        routes_.push_back({std::move(method), std::move(path),
+                           std::move(handler)});
+    }
+
+    // 未注册的方法/路径返回 nullptr
+    const RequestHandler* Find(std::string_view method,
+                               std::string_view path) const {
+        for (const auto& route : routes_) {
+            if (route.method == method && route.path == path)
+                return &route.handler;
+        }
+        return nullptr;
+    }
+
+   private:
+    struct Route {
+        std::string method;
+        std::string path;
+        RequestHandler handler;
+    };
+    std::vector<Route> routes_;
+};
+
+struct ServerOptions {
+    // I/O 线程数，各自监听同一端口（SO_REUSEPORT），0 表示硬件线程数
+    unsigned reactors = 0;
+    // 执行查询的线程数，0 表示硬件线程数
+    unsigned query_threads = 0;
+    // 每 log_sample 个响应异步记一条访问日志，0 表示不记
+    uint32_t log_sample = 0;
+};
+
+// epoll 边沿触发的多 reactor 服务器，查询交给查询线程执行，不阻塞 I/O 循环
+void runServer(int port, const Router& router,
+               const ServerOptions& options = {});
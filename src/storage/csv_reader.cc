@@ -0,0 +1,188 @@
+// src/storage/csv_reader.cc
+#include "csv_reader.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "external_sort.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace hackathon {
+
+namespace {
+
+constexpr size_t kBlockBytes = 64;
+constexpr size_t kBatchRows = 4096;
+constexpr size_t kChunksPerThread = 8;
+
+// [p, p + 64) 中 ',' 和 '\n' 的位置位图
+inline uint64_t DelimiterMask(const char* p) {
+#if defined(__AVX2__)
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+    uint32_t mlo = _mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_cmpeq_epi8(lo, comma), _mm256_cmpeq_epi8(lo, newline)));
+    uint32_t mhi = _mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_cmpeq_epi8(hi, comma), _mm256_cmpeq_epi8(hi, newline)));
+    return static_cast<uint64_t>(mhi) << 32 | mlo;
+#elif defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        uint32_t m = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, newline)));
+        mask |= static_cast<uint64_t>(m) << (16 * i);
+    }
+    return mask;
+#else
+    uint64_t mask = 0;
+    for (size_t i = 0; i < kBlockBytes; ++i) {
+        mask |= static_cast<uint64_t>(p[i] == ',' || p[i] == '\n') << i;
+    }
+    return mask;
+#endif
+}
+
+}  // namespace
+
+CsvReader::CsvReader(const std::string& path, bool skip_header) {
+    fd_ = open(path.c_str(), O_RDONLY);
+    if (fd_ == -1)
+        throw std::runtime_error("Failed to open CSV file: " + path);
+
+    struct stat st;
+    if (fstat(fd_, &st) == -1) {
+        close(fd_);
+        throw std::runtime_error("Failed to stat CSV file: " + path);
+    }
+    size_ = st.st_size;
+    if (size_ == 0)
+        return;
+
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (data == MAP_FAILED) {
+        close(fd_);
+        throw std::runtime_error("Failed to mmap CSV file: " + path);
+    }
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+
+    if (skip_header) {
+        const void* nl = memchr(data_, '\n', size_);
+        body_offset_ = nl ? static_cast<const char*>(nl) - data_ + 1 : size_;
+    }
+}
+
+CsvReader::~CsvReader() {
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+    if (fd_ != -1)
+        close(fd_);
+}
+
+void CsvReader::ForEachBatch(unsigned threads, const BatchFn& fn) const {
+    if (body_offset_ >= size_)
+        return;
+    if (threads == 0)
+        threads = 1;
+
+    // 按换行边界切块，块数多于线程数以平衡负载
+    const char* end = data_ + size_;
+    size_t body = size_ - body_offset_;
+    size_t chunk_count = std::max<size_t>(
+        1, std::min<size_t>(threads * kChunksPerThread, body / (1 << 20)));
+    std::vector<const char*> bounds;
+    bounds.push_back(data_ + body_offset_);
+    for (size_t i = 1; i < chunk_count; ++i) {
+        const char* p = data_ + body_offset_ + body * i / chunk_count;
+        if (p <= bounds.back())
+            continue;
+        const void* nl = memchr(p, '\n', end - p);
+        if (!nl)
+            break;
+        p = static_cast<const char*>(nl) + 1;
+        if (p > bounds.back() && p < end)
+            bounds.push_back(p);
+    }
+    bounds.push_back(end);
+
+    std::atomic<size_t> next_chunk{0};
+    size_t chunks = bounds.size() - 1;
+    RunInParallel(std::min<size_t>(threads, chunks), [&](unsigned worker) {
+        for (size_t c = next_chunk++; c < chunks; c = next_chunk++) {
+            ParseRange(bounds[c], bounds[c + 1], worker, fn);
+        }
+    });
+}
+
+void CsvReader::ParseRange(const char* begin, const char* end,
+                           unsigned worker, const BatchFn& fn) const {
+    std::vector<EdgeFields> rows;
+    rows.reserve(kBatchRows);
+
+    std::string_view cols[5];
+    int col = 0;
+    const char* field = begin;
+
+    auto finish_line = [&](const char* line_end) {
+        if (col == 4) {
+            if (line_end > field && line_end[-1] == '\r')
+                --line_end;
+            cols[4] = std::string_view(field, line_end - field);
+            rows.push_back({cols[0], cols[1], cols[2], cols[3], cols[4]});
+            if (rows.size() == kBatchRows) {
+                fn(worker, rows.data(), rows.size());
+                rows.clear();
+            }
+        }
+        col = 0;
+    };
+
+    // 末尾不足一个块的部分拷到补齐的缓冲里扫描
+    alignas(32) char tail[kBlockBytes];
+    for (const char* block = begin; block < end; block += kBlockBytes) {
+        size_t avail = end - block;
+        uint64_t mask;
+        if (avail >= kBlockBytes) {
+            mask = DelimiterMask(block);
+        } else {
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, block, avail);
+            mask = DelimiterMask(tail) & ((uint64_t(1) << avail) - 1);
+        }
+
+        while (mask) {
+            const char* d = block + __builtin_ctzll(mask);
+            mask &= mask - 1;
+            if (*d == ',') {
+                if (col < 4)
+                    cols[col] = std::string_view(field, d - field);
+                col++;
+            } else {
+                finish_line(d);
+            }
+            field = d + 1;
+        }
+    }
+    // 没有结尾换行的最后一行；终点标签为空时 field 已到 end
+    if (col == 4 || field < end)
+        finish_line(end);
+
+    if (!rows.empty())
+        fn(worker, rows.data(), rows.size());
+}
+
+}  // namespace hackathon
@@ -0,0 +1,53 @@
+// src/storage/csv_reader.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace hackathon {
+
+// | startId | startLabel | edgeLabel | endId | endLabel |
+struct EdgeFields {
+    std::string_view start_id;
+    std::string_view start_label;
+    std::string_view edge_label;
+    std::string_view end_id;
+    std::string_view end_label;
+};
+
+// mmap 方式读取 5 列边 CSV。
+// 文件按换行边界切分为若干块，由多个线程并行解析；分隔符用 SIMD 查找
+// （AVX2 / SSE2，否则退回标量），字段以指向映射内存的 string_view 给出，
+// 解析过程不做逐行分配。列数不为 5 的行被跳过。
+class CsvReader {
+   public:
+    // worker 为线程编号，rows 仅在回调期间有效，但其中的 string_view
+    // 在 CsvReader 析构前一直有效
+    using BatchFn =
+        std::function<void(unsigned worker, const EdgeFields* rows, size_t n)>;
+
+    CsvReader(const std::string& path, bool skip_header = true);
+    ~CsvReader();
+
+    CsvReader(const CsvReader&) = delete;
+    CsvReader& operator=(const CsvReader&) = delete;
+
+    // 用 threads 个线程解析整个文件，每攒够一批行回调一次 fn
+    void ForEachBatch(unsigned threads, const BatchFn& fn) const;
+
+    size_t size() const { return size_; }
+
+   private:
+    void ParseRange(const char* begin, const char* end, unsigned worker,
+                    const BatchFn& fn) const;
+
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t body_offset_ = 0;  // 跳过表头后的起始位置
+};
+
+}  // namespace hackathon
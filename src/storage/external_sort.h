@@ -0,0 +1,315 @@
+// src/storage/external_sort.h
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hackathon {
+
+// 边记录，按 (src, label, dst) 排序，同一源点的邻居按边标签分组
+struct EdgeRecord {
+    uint32_t src;
+    uint32_t dst;
+    uint16_t label;
+
+    static constexpr int kKeyBytes = 10;
+
+    // 第 i 个排序字节，i = 0 为最低位
+    uint8_t KeyByte(int i) const {
+        if (i < 4)
+            return static_cast<uint8_t>(dst >> (8 * i));
+        if (i < 6)
+            return static_cast<uint8_t>(label >> (8 * (i - 4)));
+        return static_cast<uint8_t>(src >> (8 * (i - 6)));
+    }
+
+    bool operator<(const EdgeRecord& other) const {
+        if (src != other.src)
+            return src < other.src;
+        if (label != other.label)
+            return label < other.label;
+        return dst < other.dst;
+    }
+};
+
+// 用 threads 个线程执行 fn(thread_index)，工作线程抛出的异常在汇合后重新抛出
+inline void RunInParallel(unsigned threads,
+                          const std::function<void(unsigned)>& fn) {
+    if (threads <= 1) {
+        fn(0);
+        return;
+    }
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto guarded = [&](unsigned t) {
+        try {
+            fn(t);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) {
+        workers.emplace_back(guarded, t);
+    }
+    guarded(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// LSD 基数排序（每轮 8 位），tmp 至少与 data 等长。
+// 所有直方图一次扫描算出，某一字节全部相同时跳过该轮。
+template <typename Record>
+void RadixSort(Record* data, Record* tmp, size_t n) {
+    if (n < 2)
+        return;
+
+    std::vector<size_t> hist(Record::kKeyBytes * 256, 0);
+    for (size_t i = 0; i < n; ++i) {
+        for (int b = 0; b < Record::kKeyBytes; ++b) {
+            hist[b * 256 + data[i].KeyByte(b)]++;
+        }
+    }
+
+    Record* from = data;
+    Record* to = tmp;
+    for (int b = 0; b < Record::kKeyBytes; ++b) {
+        size_t* h = &hist[b * 256];
+        if (h[from[0].KeyByte(b)] == n)
+            continue;
+
+        size_t sum = 0;
+        for (int d = 0; d < 256; ++d) {
+            size_t c = h[d];
+            h[d] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            to[h[from[i].KeyByte(b)]++] = from[i];
+        }
+        std::swap(from, to);
+    }
+    if (from != data) {
+        std::memcpy(data, from, n * sizeof(Record));
+    }
+}
+
+// 定长记录的多线程外部排序。
+// 记录先写入内存缓冲，缓冲达到内存预算后按线程切片并行基数排序，
+// 每个切片作为一个有序 run 落盘；Merge 时对所有 run 做 k 路归并。
+// 最后一批缓冲不落盘，直接在内存中参与归并。
+template <typename Record>
+class ExternalSorter {
+   public:
+    ExternalSorter(std::string tmp_prefix, size_t memory_budget,
+                   unsigned threads)
+        : tmp_prefix_(std::move(tmp_prefix)),
+          threads_(threads == 0 ? 1 : threads) {
+        // 基数排序需要等长的辅助空间
+        capacity_ = std::max<size_t>(memory_budget / (2 * sizeof(Record)),
+                                     kMinSliceRecords);
+    }
+
+    ~ExternalSorter() {
+        for (const auto& run : runs_) {
+            if (!run.path.empty())
+                std::remove(run.path.c_str());
+        }
+    }
+
+    ExternalSorter(const ExternalSorter&) = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+    void Add(const Record& record) { Add(&record, 1); }
+
+    // 线程安全的批量写入
+    void Add(const Record* data, size_t n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (n > 0) {
+            if (buffer_.capacity() < capacity_)
+                buffer_.reserve(capacity_);
+            size_t take = std::min(n, capacity_ - buffer_.size());
+            buffer_.insert(buffer_.end(), data, data + take);
+            data += take;
+            n -= take;
+            count_ += take;
+            if (buffer_.size() == capacity_)
+                SortBuffer(true);
+        }
+    }
+
+    uint64_t size() const { return count_; }
+
+    // 所有输入结束后调用，按序回调每条记录（不去重）
+    template <typename Fn>
+    void Merge(Fn&& fn) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SortBuffer(false);
+
+        std::vector<Cursor> cursors(runs_.size());
+        size_t file_runs = 0;
+        for (const auto& run : runs_) {
+            file_runs += run.path.empty() ? 0 : 1;
+        }
+        // 落盘 run 的读缓冲共享一半内存预算
+        size_t read_records = file_runs == 0
+                                  ? 0
+                                  : std::max<size_t>(capacity_ / file_runs,
+                                                     kMinReadRecords);
+        for (size_t i = 0; i < runs_.size(); ++i) {
+            cursors[i].Open(runs_[i], read_records);
+        }
+
+        if (cursors.size() == 1) {
+            auto& c = cursors[0];
+            while (c.Valid()) {
+                for (; c.cur < c.end; ++c.cur) {
+                    fn(*c.cur);
+                }
+                c.Refill();
+            }
+            return;
+        }
+
+        auto greater = [&cursors](size_t a, size_t b) {
+            return *cursors[b].cur < *cursors[a].cur;
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)>
+            heap(greater);
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            if (cursors[i].Valid())
+                heap.push(i);
+        }
+        while (!heap.empty()) {
+            size_t i = heap.top();
+            heap.pop();
+            fn(*cursors[i].cur);
+            if (cursors[i].Next())
+                heap.push(i);
+        }
+    }
+
+   private:
+    static constexpr size_t kMinSliceRecords = 1 << 16;
+    static constexpr size_t kMinReadRecords = 1 << 12;
+
+    struct Run {
+        std::string path;  // 为空表示内存 run
+        const Record* memory = nullptr;
+        size_t count = 0;
+    };
+
+    struct Cursor {
+        FILE* file = nullptr;
+        std::vector<Record> buffer;
+        const Record* cur = nullptr;
+        const Record* end = nullptr;
+
+        ~Cursor() {
+            if (file)
+                fclose(file);
+        }
+
+        void Open(const Run& run, size_t read_records) {
+            if (run.path.empty()) {
+                cur = run.memory;
+                end = run.memory + run.count;
+                return;
+            }
+            file = fopen(run.path.c_str(), "rb");
+            if (!file)
+                throw std::runtime_error("Failed to open sort run: " +
+                                         run.path);
+            buffer.resize(read_records);
+            Refill();
+        }
+
+        bool Valid() const { return cur < end; }
+
+        bool Refill() {
+            if (!file) {
+                cur = end;
+                return false;
+            }
+            size_t n = fread(buffer.data(), sizeof(Record), buffer.size(),
+                             file);
+            cur = buffer.data();
+            end = buffer.data() + n;
+            return n > 0;
+        }
+
+        bool Next() { return ++cur < end || Refill(); }
+    };
+
+    // 并行排序缓冲区，spill 为 true 时落盘并清空缓冲
+    void SortBuffer(bool spill) {
+        size_t n = buffer_.size();
+        if (n == 0)
+            return;
+
+        unsigned parts = static_cast<unsigned>(
+            std::min<size_t>(threads_, (n + kMinSliceRecords - 1) /
+                                           kMinSliceRecords));
+        scratch_.resize(n);
+        size_t first_run = runs_.size();
+        runs_.resize(first_run + parts);
+
+        RunInParallel(parts, [&](unsigned t) {
+            size_t begin = n * t / parts;
+            size_t end = n * (t + 1) / parts;
+            RadixSort(buffer_.data() + begin, scratch_.data() + begin,
+                      end - begin);
+
+            Run& run = runs_[first_run + t];
+            run.count = end - begin;
+            if (!spill) {
+                run.memory = buffer_.data() + begin;
+                return;
+            }
+            run.path = tmp_prefix_ + ".run" + std::to_string(first_run + t);
+            FILE* out = fopen(run.path.c_str(), "wb");
+            if (!out ||
+                fwrite(buffer_.data() + begin, sizeof(Record), run.count,
+                       out) != run.count) {
+                if (out)
+                    fclose(out);
+                throw std::runtime_error("Failed to write sort run: " +
+                                         run.path);
+            }
+            fclose(out);
+        });
+
+        if (spill) {
+            buffer_.clear();
+        } else {
+            std::vector<Record>().swap(scratch_);
+        }
+    }
+
+    std::string tmp_prefix_;
+    unsigned threads_;
+    size_t capacity_;
+    uint64_t count_ = 0;
+    std::mutex mutex_;
+    std::vector<Record> buffer_;
+    std::vector<Record> scratch_;
+    std::vector<Run> runs_;
+};
+
+}  // namespace hackathon
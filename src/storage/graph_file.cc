@@ -0,0 +1,303 @@
+// src/storage/graph_file.cc
+#include "graph_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+
+#if defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+namespace hackathon {
+
+namespace {
+
+constexpr char kMagic[8] = {'H', 'K', 'G', 'R', 'A', 'P', 'H', 0};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kEndianMark = 0x01020304;
+constexpr uint32_t kMaxSections = 64;
+constexpr size_t kCopyBuffer = size_t(4) << 20;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t header_crc;  // 计算时本字段置 0
+    uint32_t section_count;
+    uint32_t neighbor_codec;
+    uint32_t vertex_order;
+    uint64_t node_count;
+    uint64_t edge_count;
+    uint64_t file_size;
+    uint64_t alignment;
+    GraphSectionEntry sections[kMaxSections];
+};
+
+static_assert(sizeof(FileHeader) <= GraphFile::kAlignment);
+
+uint64_t alignUp(uint64_t value) {
+    return (value + GraphFile::kAlignment - 1) / GraphFile::kAlignment *
+           GraphFile::kAlignment;
+}
+
+uint32_t headerCrc(FileHeader header) {
+    header.header_crc = 0;
+    return Crc32c(0, &header, sizeof(header));
+}
+
+void writeAll(int fd, const void* data, size_t size, uint64_t offset,
+              const std::string& path) {
+    const char* ptr = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = pwrite(fd, ptr, size, offset);
+        if (n <= 0)
+            throw std::runtime_error("Failed to write graph file: " + path);
+        ptr += n;
+        size -= n;
+        offset += n;
+    }
+}
+
+FileHeader makeHeader(const GraphFileMeta& meta,
+                      const std::vector<GraphSectionEntry>& entries,
+                      uint64_t file_size) {
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.endian = kEndianMark;
+    header.section_count = entries.size();
+    header.neighbor_codec = meta.neighbor_codec;
+    header.vertex_order = meta.vertex_order;
+    header.node_count = meta.node_count;
+    header.edge_count = meta.edge_count;
+    header.file_size = file_size;
+    header.alignment = GraphFile::kAlignment;
+    std::copy(entries.begin(), entries.end(), header.sections);
+    header.header_crc = headerCrc(header);
+    return header;
+}
+
+// 只检查头部本身，段表与文件长度的关系由调用方检查
+void checkHeader(const FileHeader& header, const std::string& path) {
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+        throw std::runtime_error("Not a graph file: " + path);
+    if (header.endian != kEndianMark)
+        throw std::runtime_error("Graph file has foreign byte order: " + path);
+    if (header.version == 0 || header.version > kVersion)
+        throw std::runtime_error("Unsupported graph file version: " + path);
+    if (header.header_crc != headerCrc(header))
+        throw std::runtime_error("Graph file header checksum mismatch: " +
+                                 path);
+    if (header.section_count > kMaxSections ||
+        header.alignment != GraphFile::kAlignment)
+        throw std::runtime_error("Corrupt graph file header: " + path);
+}
+
+#if !defined(__SSE4_2__)
+const std::array<uint32_t, 256>& crcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; ++k) {
+                crc = crc & 1 ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+            }
+            t[i] = crc;
+        }
+        return t;
+    }();
+    return table;
+}
+#endif
+
+}  // namespace
+
+uint32_t Crc32c(uint32_t crc, const void* data, size_t size) {
+    const uint8_t* ptr = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+#if defined(__SSE4_2__)
+    uint64_t crc64 = crc;
+    for (; size >= 8; size -= 8, ptr += 8) {
+        uint64_t word;
+        std::memcpy(&word, ptr, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32_t>(crc64);
+    for (; size > 0; --size, ++ptr) {
+        crc = _mm_crc32_u8(crc, *ptr);
+    }
+#else
+    const auto& table = crcTable();
+    for (; size > 0; --size, ++ptr) {
+        crc = table[(crc ^ *ptr) & 0xFF] ^ (crc >> 8);
+    }
+#endif
+    return ~crc;
+}
+
+GraphFileWriter::GraphFileWriter(const std::string& path)
+    : path_(path), tmp_path_(path + ".tmp"), end_(GraphFile::kAlignment) {
+    fd_ = open(tmp_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ == -1)
+        throw std::runtime_error("Failed to create graph file: " + tmp_path_);
+}
+
+GraphFileWriter::~GraphFileWriter() {
+    if (fd_ != -1) {
+        close(fd_);
+        unlink(tmp_path_.c_str());
+    }
+}
+
+void GraphFileWriter::AddSection(GraphSection section, const void* data,
+                                 size_t size) {
+    if (entries_.size() >= kMaxSections)
+        throw std::runtime_error("Too many graph file sections");
+    writeAll(fd_, data, size, end_, tmp_path_);
+    entries_.push_back({static_cast<uint32_t>(section), Crc32c(0, data, size),
+                        end_, size});
+    end_ = alignUp(end_ + size);
+}
+
+void GraphFileWriter::AddSectionFromFile(GraphSection section,
+                                         const std::string& path) {
+    if (entries_.size() >= kMaxSections)
+        throw std::runtime_error("Too many graph file sections");
+    int in = open(path.c_str(), O_RDONLY);
+    if (in == -1)
+        throw std::runtime_error("Failed to open file: " + path);
+    std::unique_ptr<char[]> buffer(new char[kCopyBuffer]);
+    uint32_t crc = 0;
+    uint64_t size = 0;
+    while (true) {
+        ssize_t n = read(in, buffer.get(), kCopyBuffer);
+        if (n < 0) {
+            close(in);
+            throw std::runtime_error("Failed to read file: " + path);
+        }
+        if (n == 0)
+            break;
+        crc = Crc32c(crc, buffer.get(), n);
+        writeAll(fd_, buffer.get(), n, end_ + size, tmp_path_);
+        size += n;
+    }
+    close(in);
+    entries_.push_back({static_cast<uint32_t>(section), crc, end_, size});
+    end_ = alignUp(end_ + size);
+}
+
+void GraphFileWriter::Finish(const GraphFileMeta& meta) {
+    uint64_t file_size = GraphFile::kAlignment;
+    for (const auto& entry : entries_) {
+        file_size = std::max(file_size, entry.offset + entry.size);
+    }
+    FileHeader header = makeHeader(meta, entries_, file_size);
+    if (ftruncate(fd_, file_size) == -1)
+        throw std::runtime_error("Failed to resize graph file: " + tmp_path_);
+    // 数据先落盘，头部最后写，改名后才对读者可见
+    if (fdatasync(fd_) == -1)
+        throw std::runtime_error("Failed to sync graph file: " + tmp_path_);
+    writeAll(fd_, &header, sizeof(header), 0, tmp_path_);
+    if (fdatasync(fd_) == -1)
+        throw std::runtime_error("Failed to sync graph file: " + tmp_path_);
+    close(fd_);
+    fd_ = -1;
+    std::filesystem::rename(tmp_path_, path_);
+}
+
+void GraphFile::Open(const std::string& path, bool populate) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error("Failed to open graph file: " + path);
+    struct stat st;
+    if (fstat(fd, &st) == -1 ||
+        static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        close(fd);
+        throw std::runtime_error("Truncated graph file: " + path);
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ,
+                      MAP_SHARED | (populate ? MAP_POPULATE : 0), fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        throw std::runtime_error("Failed to mmap graph file: " + path);
+    data_ = static_cast<uint8_t*>(data);
+    size_ = st.st_size;
+
+    try {
+        FileHeader header;
+        std::memcpy(&header, data_, sizeof(header));
+        checkHeader(header, path);
+        if (header.file_size != size_)
+            throw std::runtime_error("Truncated graph file: " + path);
+
+        entries_.assign(header.sections,
+                        header.sections + header.section_count);
+        std::vector<GraphSectionEntry> sorted = entries_;
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const auto& a, const auto& b) {
+                      return a.offset < b.offset;
+                  });
+        uint64_t end = kAlignment;
+        for (const auto& entry : sorted) {
+            if (entry.offset % kAlignment != 0 || entry.offset < end ||
+                entry.size > size_ || entry.offset > size_ - entry.size)
+                throw std::runtime_error("Corrupt graph file section table: " +
+                                         path);
+            end = entry.offset + entry.size;
+        }
+
+        meta_.neighbor_codec = header.neighbor_codec;
+        meta_.vertex_order = header.vertex_order;
+        meta_.node_count = header.node_count;
+        meta_.edge_count = header.edge_count;
+        checksum_ = header.header_crc;
+    } catch (...) {
+        Close();
+        throw;
+    }
+}
+
+void GraphFile::Close() {
+    if (data_)
+        munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+    meta_ = {};
+    checksum_ = 0;
+    entries_.clear();
+}
+
+std::span<const uint8_t> GraphFile::Section(GraphSection section) const {
+    for (const auto& entry : entries_) {
+        if (entry.section == static_cast<uint32_t>(section))
+            return {data_ + entry.offset, entry.size};
+    }
+    return {};
+}
+
+bool GraphFile::HasSection(GraphSection section) const {
+    for (const auto& entry : entries_) {
+        if (entry.section == static_cast<uint32_t>(section))
+            return true;
+    }
+    return false;
+}
+
+void GraphFile::Verify() const {
+    for (const auto& entry : entries_) {
+        if (Crc32c(0, data_ + entry.offset, entry.size) != entry.crc)
+            throw std::runtime_error(
+                "Checksum mismatch in graph file section " +
+                std::to_string(entry.section));
+    }
+}
+
+}  // namespace hackathon
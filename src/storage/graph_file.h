@@ -0,0 +1,117 @@
+// src/storage/graph_file.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace hackathon {
+
+// 单文件图容器中的段，数值写入段表，不可修改已有取值
+enum class GraphSection : uint32_t {
+    kForwardOffsets = 1,
+    kForwardNeighbors = 2,
+    kForwardSegmentOffsets = 3,
+    kForwardSegments = 4,
+    kBackwardOffsets = 5,
+    kBackwardNeighbors = 6,
+    kBackwardSegmentOffsets = 7,
+    kBackwardSegments = 8,
+    kVertexLabels = 9,
+    kLabelNames = 10,
+    kNodeStrings = 11,
+    kNodeOffsets = 12,
+    kNodeIndex = 13,
+    kVertexOrder = 14,
+    kForwardDegrees = 15,
+    kBackwardDegrees = 16,
+    kHopSketches = 17,  // k 跳 HyperLogLog 草图，由后台任务写入图旁的独立容器
+};
+
+// 容器头中与段无关的元数据
+struct GraphFileMeta {
+    uint32_t neighbor_codec = 0;
+    uint32_t vertex_order = 0;
+    uint64_t node_count = 0;
+    uint64_t edge_count = 0;
+};
+
+// 段表中的一项
+struct GraphSectionEntry {
+    uint32_t section;
+    uint32_t crc;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// CRC32C（Castagnoli），有 SSE4.2 时用硬件指令，否则查表
+uint32_t Crc32c(uint32_t crc, const void* data, size_t size);
+
+// 容器格式（小端）：
+//   [0, 2 MB)   头部：magic、版本、字节序标记、元数据、段表和头部自身的 CRC32C
+//   之后各段   每段起点按 2 MB 对齐（可用大页映射），段间空洞不占磁盘
+// 段表记录每段的偏移、长度和 CRC32C。写入时先写临时文件，头部最后写，
+// 完成后原子地改名，中途失败不会留下半个图。
+class GraphFileWriter {
+   public:
+    explicit GraphFileWriter(const std::string& path);
+    ~GraphFileWriter();
+
+    GraphFileWriter(const GraphFileWriter&) = delete;
+    GraphFileWriter& operator=(const GraphFileWriter&) = delete;
+
+    void AddSection(GraphSection section, const void* data, size_t size);
+    // 从文件流式拷贝一段，边拷贝边计算 CRC
+    void AddSectionFromFile(GraphSection section, const std::string& path);
+
+    // 写入头部并改名为 path
+    void Finish(const GraphFileMeta& meta);
+
+   private:
+    std::string path_;
+    std::string tmp_path_;
+    int fd_ = -1;
+    uint64_t end_;  // 下一段的起点
+    std::vector<GraphSectionEntry> entries_;
+};
+
+// 只读打开容器，整体 mmap。打开时只校验头部和段表（与数据量无关）：
+// magic / 版本 / 字节序、头部 CRC、段的对齐与越界、文件长度是否被截断。
+// 段数据的 CRC 由 Verify 按需校验。
+class GraphFile {
+   public:
+    static constexpr size_t kAlignment = size_t(2) << 20;
+
+    GraphFile() = default;
+    ~GraphFile() { Close(); }
+
+    GraphFile(const GraphFile&) = delete;
+    GraphFile& operator=(const GraphFile&) = delete;
+
+    // 格式错误时抛出异常。populate 为 true 时以 MAP_POPULATE 映射
+    void Open(const std::string& path, bool populate = false);
+    void Close();
+
+    bool IsOpen() const { return data_ != nullptr; }
+    const GraphFileMeta& Meta() const { return meta_; }
+    // 头部 CRC，覆盖元数据和各段的 CRC，可作为文件内容的指纹
+    uint32_t Checksum() const { return checksum_; }
+
+    // 段不存在时返回空
+    std::span<const uint8_t> Section(GraphSection section) const;
+    bool HasSection(GraphSection section) const;
+
+    // 校验所有段的 CRC32C，不一致时抛出异常
+    void Verify() const;
+
+   private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    GraphFileMeta meta_;
+    uint32_t checksum_ = 0;
+    std::vector<GraphSectionEntry> entries_;
+};
+
+}  // namespace hackathon
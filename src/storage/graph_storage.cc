@@ -1,37 +1,381 @@
 // src/storage/graph_storage.cc
 #include "graph_storage.h"
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <queue>
-#include <set>
-#include <sstream>
+#include <thread>
+#include "csv_reader.h"
+#include "external_sort.h"
+#include "node_interner.h"
 
 namespace hackathon {
 
-std::vector<uint8_t> EncodeVarint(uint32_t value) {
-    std::vector<uint8_t> result;
-    while (value > 0x7F) {
-        result.push_back((value & 0x7F) | 0x80);
-        value >>= 7;
+namespace {
+
+// 格式头，记录邻居表编码、顶点编号方式和边数；不存在时按旧的 varint 格式读取。
+// 版本 1 只有前三个字段，vertex_order 原为保留字段（0 即未重编号）。
+struct FormatHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t neighbor_codec;
+    uint32_t vertex_order;
+    uint64_t edge_count;
+};
+
+constexpr char kFormatMagic[4] = {'H', 'K', 'G', 'S'};
+constexpr uint32_t kFormatVersion = 2;
+constexpr size_t kFormatV1Size = 12;
+
+// 构建时各段先写成散文件，最后按此表打包进单文件容器
+struct SectionFile {
+    GraphSection section;
+    const char* name;
+};
+
+constexpr SectionFile kSectionFiles[] = {
+    {GraphSection::kForwardOffsets, "forward_offsets.bin"},
+    {GraphSection::kBackwardOffsets, "backward_offsets.bin"},
+    {GraphSection::kForwardSegmentOffsets, "forward_segment_offsets.bin"},
+    {GraphSection::kBackwardSegmentOffsets, "backward_segment_offsets.bin"},
+    {GraphSection::kForwardDegrees, "forward_degrees.bin"},
+    {GraphSection::kBackwardDegrees, "backward_degrees.bin"},
+    {GraphSection::kNodeOffsets, "node_offsets.bin"},
+    {GraphSection::kNodeIndex, "node_index.bin"},
+    {GraphSection::kVertexLabels, "vertex_labels.bin"},
+    {GraphSection::kLabelNames, "labels.bin"},
+    {GraphSection::kForwardSegments, "forward_segments.bin"},
+    {GraphSection::kBackwardSegments, "backward_segments.bin"},
+    {GraphSection::kForwardNeighbors, "forward_neighbors.bin"},
+    {GraphSection::kBackwardNeighbors, "backward_neighbors.bin"},
+    {GraphSection::kNodeStrings, "node_strings.bin"},
+    {GraphSection::kVertexOrder, "vertex_order.bin"},
+};
+
+constexpr char kGraphFileName[] = "/graph.hkg";
+
+constexpr size_t kPageSize = 4096;
+constexpr size_t kHugePageSize = size_t(2) << 20;
+// 预热和复制按块分给线程
+constexpr size_t kWarmupChunk = size_t(64) << 20;
+
+// 待预热的区间，dst 非空时复制到 dst，否则逐页读一个字节
+struct WarmupRange {
+    const uint8_t* src;
+    uint8_t* dst;
+    size_t size;
+};
+
+void warmRanges(const std::vector<WarmupRange>& ranges, unsigned threads) {
+    std::vector<WarmupRange> chunks;
+    for (const auto& range : ranges) {
+        for (size_t pos = 0; pos < range.size; pos += kWarmupChunk) {
+            chunks.push_back({range.src + pos,
+                              range.dst ? range.dst + pos : nullptr,
+                              std::min(kWarmupChunk, range.size - pos)});
+        }
     }
-    result.push_back(value);
-    return result;
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> sink{0};
+    RunInParallel(threads, [&](unsigned) {
+        uint64_t sum = 0;
+        for (size_t i = next++; i < chunks.size(); i = next++) {
+            const WarmupRange& chunk = chunks[i];
+            if (chunk.dst) {
+                std::memcpy(chunk.dst, chunk.src, chunk.size);
+                continue;
+            }
+            for (size_t pos = 0; pos < chunk.size; pos += kPageSize) {
+                sum += chunk.src[pos];
+            }
+        }
+        // 写入原子变量，防止读取被优化掉
+        sink += sum;
+    });
 }
 
-uint32_t DecodeVarint(const uint8_t*& data) {
-    uint32_t value = 0;
-    int shift = 0;
-    while (true) {
-        uint8_t byte = *data++;
-        value |= (byte & 0x7F) << shift;
-        if ((byte & 0x80) == 0)
-            break;
-        shift += 7;
-    }
-    return value;
+// 分配 2 MB 对齐的匿名内存并申请透明大页，mapped 返回实际映射长度
+uint8_t* allocateHugePages(size_t size, size_t& mapped) {
+    mapped = (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    size_t reserve = mapped + kHugePageSize;
+    void* raw = mmap(nullptr, reserve, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        throw std::runtime_error("Failed to allocate huge page memory");
+    uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (begin + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    if (aligned > begin)
+        munmap(raw, aligned - begin);
+    uintptr_t tail = aligned + mapped;
+    if (begin + reserve > tail)
+        munmap(reinterpret_cast<void*>(tail), begin + reserve - tail);
+    madvise(reinterpret_cast<void*>(aligned), mapped, MADV_HUGEPAGE);
+    return reinterpret_cast<uint8_t*>(aligned);
+}
+
+// madvise 要求起点按页对齐，失败时忽略（建议性质）
+void adviseRange(const uint8_t* data, size_t size, int advice) {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(kPageSize - 1);
+    size_t length = reinterpret_cast<uintptr_t>(data) + size - begin;
+    madvise(reinterpret_cast<void*>(begin), length, advice);
 }
 
+// 解析待定边时每攒够这么多条边（或字节）写出一次
+constexpr size_t kResolveBatch = 1 << 16;
+
+// 构建时的标签编号，按首次出现的顺序分配。
+// 标签种类很少，各线程先查本地缓存，未命中再加锁查共享表
+class LabelAssigner {
+   public:
+    explicit LabelAssigner(unsigned threads) : local_(threads) {}
+
+    uint16_t Assign(unsigned worker, std::string_view name) {
+        auto& local = local_[worker];
+        auto it = local.find(name);
+        if (it != local.end())
+            return it->second;
+        uint16_t id;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto shared = ids_.find(name);
+            if (shared != ids_.end()) {
+                id = shared->second;
+            } else {
+                if (names_.size() >= GraphStorage::kNoLabel)
+                    throw std::runtime_error("Too many distinct labels");
+                id = names_.size();
+                ids_.emplace(name, id);
+                names_.emplace_back(name);
+            }
+        }
+        local.emplace(name, id);
+        return id;
+    }
+
+    void MoveTo(std::vector<std::string>& names, LabelIdMap& ids) {
+        names = std::move(names_);
+        ids = std::move(ids_);
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<std::string> names_;
+    LabelIdMap ids_;
+    std::vector<LabelIdMap> local_;
+};
+
+// 顺序写文件，数据先攒在固定大小的缓冲里，满了整块写出，
+// 内存占用与写出的总量无关
+class BufferedFileWriter {
+   public:
+    BufferedFileWriter(const std::string& path, size_t buffer_size)
+        : path_(path),
+          capacity_(std::max(buffer_size, kMinBuffer)),
+          buffer_(new char[std::max(buffer_size, kMinBuffer)]) {
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ == -1)
+            throw std::runtime_error("Failed to create file: " + path);
+    }
+
+    ~BufferedFileWriter() {
+        if (fd_ != -1)
+            close(fd_);
+    }
+
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    void Write(const void* data, size_t size) {
+        if (used_ + size > capacity_)
+            Flush();
+        if (size >= capacity_) {
+            WriteAll(data, size);
+            return;
+        }
+        std::memcpy(buffer_.get() + used_, data, size);
+        used_ += size;
+    }
+
+    template <typename T>
+    void Put(T value) {
+        Write(&value, sizeof(value));
+    }
+
+    void Close() {
+        Flush();
+        if (close(fd_) == -1) {
+            fd_ = -1;
+            throw std::runtime_error("Failed to write file: " + path_);
+        }
+        fd_ = -1;
+    }
+
+   private:
+    static constexpr size_t kMinBuffer = size_t(64) << 10;
+
+    void Flush() {
+        WriteAll(buffer_.get(), used_);
+        used_ = 0;
+    }
+
+    void WriteAll(const void* data, size_t size) {
+        const char* ptr = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = write(fd_, ptr, size);
+            if (n <= 0)
+                throw std::runtime_error("Failed to write file: " + path_);
+            ptr += n;
+            size -= n;
+        }
+    }
+
+    std::string path_;
+    int fd_ = -1;
+    size_t capacity_;
+    size_t used_ = 0;
+    std::unique_ptr<char[]> buffer_;
+};
+
+// 至少一个端点还没有 ID 的边，未解析的端点为 kPending，保留字符串
+struct PendingEdge {
+    uint32_t src;
+    uint32_t dst;
+    uint16_t label;
+    uint16_t src_label;
+    uint16_t dst_label;
+    std::string_view src_id;
+    std::string_view dst_id;
+};
+
+// 待解析的边按未解析端点中最小的分区号分桶落盘。
+// 记录为 [PendingHeader][src 字符串][dst 字符串]，已解析的端点不写字符串
+class PendingEdges {
+   public:
+    // 一个线程攒的一批记录，按桶分开，Append 时整体写入
+    class Batch {
+       public:
+        void Add(const NodeInterner& nodes, const PendingEdge& edge) {
+            unsigned bucket = nodes.Partitions();
+            Header header{edge.src, edge.dst, edge.label, edge.src_label,
+                          edge.dst_label, 0, 0, 0};
+            if (edge.src == NodeInterner::kPending) {
+                bucket = nodes.PartitionOf(edge.src_id);
+                header.src_len = edge.src_id.size();
+            }
+            if (edge.dst == NodeInterner::kPending) {
+                bucket = std::min(bucket, nodes.PartitionOf(edge.dst_id));
+                header.dst_len = edge.dst_id.size();
+            }
+            std::string& out = buckets_[bucket];
+            out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.append(edge.src_id.data(), header.src_len);
+            out.append(edge.dst_id.data(), header.dst_len);
+            bytes_ += sizeof(header) + header.src_len + header.dst_len;
+        }
+
+        size_t Bytes() const { return bytes_; }
+
+       private:
+        friend class PendingEdges;
+        std::map<unsigned, std::string> buckets_;
+        size_t bytes_ = 0;
+    };
+
+    PendingEdges(const std::string& prefix, unsigned buckets)
+        : prefix_(prefix),
+          files_(buckets, nullptr),
+          mutexes_(new std::mutex[buckets]) {}
+
+    ~PendingEdges() {
+        for (unsigned b = 0; b < files_.size(); ++b) {
+            if (files_[b])
+                fclose(files_[b]);
+            std::error_code ec;
+            std::filesystem::remove(Path(b), ec);
+        }
+    }
+
+    // 线程安全，写入后清空 batch
+    void Append(Batch& batch) {
+        for (auto& [bucket, data] : batch.buckets_) {
+            std::lock_guard<std::mutex> lock(mutexes_[bucket]);
+            if (!files_[bucket]) {
+                files_[bucket] = fopen(Path(bucket).c_str(), "wb");
+                if (!files_[bucket])
+                    throw std::runtime_error("Failed to create file: " +
+                                             Path(bucket));
+            }
+            if (fwrite(data.data(), 1, data.size(), files_[bucket]) !=
+                data.size())
+                throw std::runtime_error("Failed to write file: " +
+                                         Path(bucket));
+        }
+        batch.buckets_.clear();
+        batch.bytes_ = 0;
+    }
+
+    bool Empty(unsigned bucket) const { return files_[bucket] == nullptr; }
+
+    // 读出桶内全部记录后删除该桶，回调中的字符串视图只在回调期间有效
+    template <typename Fn>
+    void ForEach(unsigned bucket, Fn&& fn) {
+        if (!files_[bucket])
+            return;
+        fclose(files_[bucket]);
+        files_[bucket] = nullptr;
+        FILE* in = fopen(Path(bucket).c_str(), "rb");
+        if (!in)
+            throw std::runtime_error("Failed to open file: " + Path(bucket));
+        Header header;
+        std::string src_id;
+        std::string dst_id;
+        bool ok = true;
+        while (fread(&header, sizeof(header), 1, in) == 1) {
+            src_id.resize(header.src_len);
+            dst_id.resize(header.dst_len);
+            if (fread(src_id.data(), 1, src_id.size(), in) != src_id.size() ||
+                fread(dst_id.data(), 1, dst_id.size(), in) != dst_id.size()) {
+                ok = false;
+                break;
+            }
+            PendingEdge edge{header.src,       header.dst, header.label,
+                             header.src_label, header.dst_label,
+                             src_id,           dst_id};
+            fn(edge);
+        }
+        fclose(in);
+        std::filesystem::remove(Path(bucket));
+        if (!ok)
+            throw std::runtime_error("Corrupt pending edge file");
+    }
+
+   private:
+    struct Header {
+        uint32_t src;
+        uint32_t dst;
+        uint16_t label;
+        uint16_t src_label;
+        uint16_t dst_label;
+        uint16_t reserved;
+        uint32_t src_len;
+        uint32_t dst_len;
+    };
+
+    std::string Path(unsigned bucket) const {
+        return prefix_ + "_" + std::to_string(bucket) + ".bin";
+    }
+
+    std::string prefix_;
+    std::vector<FILE*> files_;
+    std::unique_ptr<std::mutex[]> mutexes_;
+};
+
+}  // namespace
+
 void GraphStorage::MapFile(const std::string& path, CSR& csr,
                            bool read_only) const {
     int fd = open(path.c_str(), read_only ? O_RDONLY : O_RDWR);
@@ -44,59 +388,71 @@ void GraphStorage::MapFile(const std::string& path, CSR& csr,
         throw std::runtime_error("Failed to stat file: " + path);
     }
 
+    csr.fd = fd;
+    csr.size = st.st_size;
+    csr.is_mapped = true;
+    if (st.st_size == 0) {
+        // 空文件（如无边的图）无需映射
+        csr.data = nullptr;
+        return;
+    }
+
     void* data =
         mmap(nullptr, st.st_size,
              read_only ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (data == MAP_FAILED) {
         close(fd);
+        csr = {-1, nullptr, 0, false};
         throw std::runtime_error("Failed to mmap file: " + path);
     }
-
-    csr.fd = fd;
     csr.data = static_cast<uint8_t*>(data);
-    csr.size = st.st_size;
-    csr.is_mapped = true;
 }
 
+// 指向单文件容器内部的段 is_mapped 为 false，只清空，由 graph_file_ 统一解除映射
 void GraphStorage::UnmapFile(CSR& csr) const {
     if (csr.is_mapped) {
-        munmap(csr.data, csr.size);
+        if (csr.data)
+            munmap(csr.data, csr.size);
         close(csr.fd);
-        csr.is_mapped = false;
-        csr.data = nullptr;
-        csr.fd = -1;
     }
+    csr = {-1, nullptr, 0, false};
 }
 
-std::vector<uint8_t> GraphStorage::CompressNeighbors(
-    const std::vector<uint32_t>& neighbors) {
-    if (neighbors.empty())
-        return {};
-
-    std::vector<uint8_t> result;
-    uint32_t prev = 0;
-    for (uint32_t val : neighbors) {
-        uint32_t delta = val - prev;
-        auto encoded = EncodeVarint(delta);
-        result.insert(result.end(), encoded.begin(), encoded.end());
-        prev = val;
-    }
-    return result;
+void GraphStorage::WriteFormatHeader() {
+    FormatHeader header{};
+    std::memcpy(header.magic, kFormatMagic, sizeof(kFormatMagic));
+    header.version = kFormatVersion;
+    header.neighbor_codec = static_cast<uint32_t>(codec_);
+    header.vertex_order = static_cast<uint32_t>(vertex_order_);
+    header.edge_count = edge_count_;
+    WriteBinaryFile(base_dir_ + "/format.bin", &header, sizeof(header));
 }
 
-std::vector<uint32_t> GraphStorage::DecompressNeighbors(const uint8_t* data,
-                                                        size_t size) {
-    std::vector<uint32_t> result;
-    const uint8_t* ptr = data;
-    const uint8_t* end = data + size;
-    uint32_t prev = 0;
+void GraphStorage::ReadFormatHeader() {
+    std::string path = base_dir_ + "/format.bin";
+    codec_ = NeighborCodec::kVarint;
+    vertex_order_ = VertexOrder::kNone;
+    if (!std::filesystem::exists(path))
+        return;
 
-    while (ptr < end) {
-        uint32_t delta = DecodeVarint(ptr);
-        prev += delta;
-        result.push_back(prev);
-    }
-    return result;
+    auto data = ReadBinaryFile(path);
+    FormatHeader header{};
+    if (data.size() < kFormatV1Size)
+        throw std::runtime_error("Corrupt format header: " + path);
+    std::memcpy(&header, data.data(), std::min(data.size(), sizeof(header)));
+    if (std::memcmp(header.magic, kFormatMagic, sizeof(kFormatMagic)) != 0 ||
+        header.version == 0 || header.version > kFormatVersion)
+        throw std::runtime_error("Unsupported graph format: " + path);
+    if (header.version >= 2 && data.size() != sizeof(header))
+        throw std::runtime_error("Corrupt format header: " + path);
+    if (header.neighbor_codec > static_cast<uint32_t>(
+                                    NeighborCodec::kStreamVByte))
+        throw std::runtime_error("Unknown neighbor codec in " + path);
+    if (header.vertex_order > static_cast<uint32_t>(VertexOrder::kGorder))
+        throw std::runtime_error("Unknown vertex order in " + path);
+    codec_ = static_cast<NeighborCodec>(header.neighbor_codec);
+    vertex_order_ = static_cast<VertexOrder>(header.vertex_order);
+    edge_count_ = header.edge_count;
 }
 
 void GraphStorage::WriteBinaryFile(const std::string& path, const void* data,
@@ -117,303 +473,792 @@ std::vector<uint8_t> GraphStorage::ReadBinaryFile(const std::string& path) {
     return data;
 }
 
-GraphStorage::GraphStorage(const std::string& base_dir) {
+GraphStorage::GraphStorage(const std::string& base_dir,
+                           const LoadOptions& load_options)
+    : base_dir_(base_dir), load_options_(load_options) {
     // 初始化 CSR 结构
     forward_offsets_ = {-1, nullptr, 0, false};
     forward_neighbors_ = {-1, nullptr, 0, false};
     backward_offsets_ = {-1, nullptr, 0, false};
     backward_neighbors_ = {-1, nullptr, 0, false};
+    forward_segment_offsets_ = {-1, nullptr, 0, false};
+    forward_segments_ = {-1, nullptr, 0, false};
+    backward_segment_offsets_ = {-1, nullptr, 0, false};
+    backward_segments_ = {-1, nullptr, 0, false};
+    forward_degrees_ = {-1, nullptr, 0, false};
+    backward_degrees_ = {-1, nullptr, 0, false};
+    vertex_labels_ = {-1, nullptr, 0, false};
+    node_strings_ = {-1, nullptr, 0, false};
+    node_offsets_ = {-1, nullptr, 0, false};
+    node_index_ = {-1, nullptr, 0, false};
 
-    std::string forward_offsets_path = base_dir + "/forward_offsets.bin";
-    std::string forward_neighbors_path = base_dir + "/forward_neighbors.bin";
-    std::string backward_offsets_path = base_dir + "/backward_offsets.bin";
-    std::string backward_neighbors_path = base_dir + "/backward_neighbors.bin";
-    std::string id_to_str_path = base_dir + "/id_to_str.bin";
-
-    if (std::filesystem::exists(forward_offsets_path)) {
-        const_cast<GraphStorage*>(this)->MapFile(forward_offsets_path,
-                                                 forward_offsets_, true);
-        const_cast<GraphStorage*>(this)->MapFile(forward_neighbors_path,
-                                                 forward_neighbors_, true);
-
-        // 流式加载节点映射
-        std::ifstream id_file(id_to_str_path, std::ios::binary);
-        if (id_file) {
-            uint32_t count;
-            id_file.read(reinterpret_cast<char*>(&count), sizeof(count));
-            id_to_str_.resize(count);
-            for (uint32_t i = 0; i < count; ++i) {
-                uint32_t len;
-                id_file.read(reinterpret_cast<char*>(&len), sizeof(len));
-                std::string str(len, '\0');
-                id_file.read(&str[0], len);
-                id_to_str_[i] = str;
-                str_to_id_[str] = i;
-            }
-            node_count_ = count;
-        }
-    }
+    Load();
 }
 
 GraphStorage::~GraphStorage() {
-    UnmapFile(forward_offsets_);
-    UnmapFile(forward_neighbors_);
-    UnmapFile(backward_offsets_);
-    UnmapFile(backward_neighbors_);
+    Unload();
 }
 
-void GraphStorage::BuildFromCSV(const std::string& csv_path) {
-    std::string base_dir =
-        std::filesystem::path(csv_path).parent_path().string() + "/graph_data";
-    std::filesystem::create_directories(base_dir);
+// 启动时映射正反两个方向的 CSR 并加载节点映射，查询路径上不再打开文件。
+// 优先使用单文件容器，没有时按旧的散文件目录加载
+void GraphStorage::Load() {
+    warmup_ = {};
+    if (std::filesystem::exists(base_dir_ + kGraphFileName)) {
+        OpenGraphFile();
+        ApplyMappingPolicy();
+        return;
+    }
+    if (!std::filesystem::exists(base_dir_ + "/forward_offsets.bin"))
+        return;
+    if (!std::filesystem::exists(base_dir_ + "/backward_offsets.bin"))
+        throw std::runtime_error("Missing backward CSR in " + base_dir_ +
+                                 ", rebuild the graph");
+    ReadFormatHeader();
+    if (!std::filesystem::exists(base_dir_ + "/node_index.bin") &&
+        std::filesystem::exists(base_dir_ + "/id_to_str.bin"))
+        ConvertLegacyNodeIds();
+    if (std::filesystem::exists(base_dir_ + "/node_index.bin"))
+        MapNodeDictionary();
+    MapCSRFiles();
+    ReadLabels();
 
-    // 第一步：收集所有节点字符串（使用临时文件）
-    std::string nodes_temp = base_dir + "/nodes_temp.bin";
-    std::ofstream nodes_out(nodes_temp, std::ios::binary);
-
-    std::ifstream csv_file(csv_path);
-    if (!csv_file)
-        throw std::runtime_error("Failed to open CSV file");
-
-    std::string line;
-    uint64_t edge_count = 0;
-
-    // 第一遍：收集节点
-    while (std::getline(csv_file, line)) {
-        std::istringstream iss(line);
-        std::string start_id, end_id;
-        if (std::getline(iss, start_id, ',') &&
-            std::getline(iss, end_id, ',') &&
-            std::getline(iss, start_id, ',') &&
-            std::getline(iss, end_id, ',')) {
-
-            // 写入起始节点
-            uint32_t len = start_id.size();
-            nodes_out.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            nodes_out.write(start_id.c_str(), len);
-
-            // 写入结束节点
-            len = end_id.size();
-            nodes_out.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            nodes_out.write(end_id.c_str(), len);
-
-            edge_count++;
+    // 没有格式头的旧目录不记录边数，加载时数一遍
+    if (edge_count_ == 0 && forward_neighbors_.size > 0) {
+        for (uint32_t v = 0; v < node_count_; ++v) {
+            edge_count_ += OutDegree(v);
         }
     }
-    nodes_out.close();
+    ApplyMappingPolicy();
+}
 
-    // 第二步：排序和去重节点
-    std::string nodes_sorted = base_dir + "/nodes_sorted.bin";
-    std::string sort_cmd = "sort -u " + nodes_temp + " -o " + nodes_sorted;
-    if (system(sort_cmd.c_str()) != 0) {
-        throw std::runtime_error("Failed to sort nodes");
+// 打开时只检查头部和段表，段数据的校验和由 VerifyChecksums 按需校验
+void GraphStorage::OpenGraphFile() {
+    std::string path = base_dir_ + kGraphFileName;
+    auto start = std::chrono::steady_clock::now();
+    bool populate = load_options_.prefault == Prefault::kPopulate;
+    graph_file_.Open(path, populate);
+    warmup_ = {};
+    if (populate) {
+        warmup_.seconds = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+        warmup_.prefaulted_bytes = std::filesystem::file_size(path);
     }
+    const GraphFileMeta& meta = graph_file_.Meta();
+    if (meta.neighbor_codec >
+        static_cast<uint32_t>(NeighborCodec::kStreamVByte))
+        throw std::runtime_error("Unknown neighbor codec in " + path);
+    if (meta.vertex_order > static_cast<uint32_t>(VertexOrder::kGorder))
+        throw std::runtime_error("Unknown vertex order in " + path);
+    codec_ = static_cast<NeighborCodec>(meta.neighbor_codec);
+    vertex_order_ = static_cast<VertexOrder>(meta.vertex_order);
+    edge_count_ = meta.edge_count;
 
-    // 第三步：构建节点映射
-    std::ifstream nodes_in(nodes_sorted, std::ios::binary);
-    std::unordered_map<std::string, uint32_t> str_to_id;
-    std::vector<std::string> id_to_str;
+    auto attach = [&](GraphSection section, CSR& csr) {
+        auto data = graph_file_.Section(section);
+        csr = {-1, const_cast<uint8_t*>(data.data()), data.size(), false};
+    };
+    attach(GraphSection::kForwardOffsets, forward_offsets_);
+    attach(GraphSection::kForwardNeighbors, forward_neighbors_);
+    attach(GraphSection::kBackwardOffsets, backward_offsets_);
+    attach(GraphSection::kBackwardNeighbors, backward_neighbors_);
+    attach(GraphSection::kForwardSegmentOffsets, forward_segment_offsets_);
+    attach(GraphSection::kForwardSegments, forward_segments_);
+    attach(GraphSection::kBackwardSegmentOffsets, backward_segment_offsets_);
+    attach(GraphSection::kBackwardSegments, backward_segments_);
+    attach(GraphSection::kForwardDegrees, forward_degrees_);
+    attach(GraphSection::kBackwardDegrees, backward_degrees_);
+    attach(GraphSection::kVertexLabels, vertex_labels_);
+    attach(GraphSection::kNodeStrings, node_strings_);
+    attach(GraphSection::kNodeOffsets, node_offsets_);
+    attach(GraphSection::kNodeIndex, node_index_);
+    ParseLabels(graph_file_.Section(GraphSection::kLabelNames));
 
-    uint32_t node_id = 0;
-    while (true) {
-        uint32_t len;
-        nodes_in.read(reinterpret_cast<char*>(&len), sizeof(len));
-        if (nodes_in.eof())
-            break;
+    node_dict_ = StringDictionary(node_strings_.data, node_strings_.size,
+                                  node_offsets_.data, node_offsets_.size,
+                                  node_index_.data, node_index_.size);
+    node_count_ = node_dict_.Size();
+    if (node_count_ != meta.node_count)
+        throw std::runtime_error("Inconsistent node count in " + path);
+    DetectOffsetWidth();
+}
 
-        std::string str(len, '\0');
-        nodes_in.read(&str[0], len);
-        str_to_id[str] = node_id;
-        id_to_str.push_back(str);
-        node_id++;
+// 散文件打包进 graph.hkg 后删除。容器先写临时文件再改名，
+// 中途失败时旧的容器（如有）保持不变
+void GraphStorage::PackGraphFile() {
+    UnmapFiles();
+    {
+        GraphFileWriter writer(base_dir_ + kGraphFileName);
+        for (const auto& file : kSectionFiles) {
+            std::string path = base_dir_ + "/" + file.name;
+            if (std::filesystem::exists(path))
+                writer.AddSectionFromFile(file.section, path);
+        }
+        GraphFileMeta meta;
+        meta.neighbor_codec = static_cast<uint32_t>(codec_);
+        meta.vertex_order = static_cast<uint32_t>(vertex_order_);
+        meta.node_count = node_count_;
+        meta.edge_count = edge_count_;
+        writer.Finish(meta);
     }
-    node_count_ = node_id;
-    edge_count_ = edge_count;
+    for (const auto& file : kSectionFiles) {
+        std::filesystem::remove(base_dir_ + "/" + file.name);
+    }
+    std::filesystem::remove(base_dir_ + "/format.bin");
+    vertex_label_names_.clear();
+    edge_label_names_.clear();
+    vertex_label_ids_.clear();
+    edge_label_ids_.clear();
+    OpenGraphFile();
+}
 
-    // 第四步：处理边（流式处理）
-    std::string edges_temp = base_dir + "/edges_temp.bin";
-    std::ofstream edges_out(edges_temp, std::ios::binary);
+// 按 load_options_ 预热映射的段。顺序：复制到大页内存、madvise、
+// 预取缺页、mlock。旧的散文件目录不支持 MAP_POPULATE，按 kParallel 处理
+void GraphStorage::ApplyMappingPolicy() {
+    const LoadOptions& options = load_options_;
+    auto start = std::chrono::steady_clock::now();
+    unsigned threads = options.threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
 
-    csv_file.clear();
-    csv_file.seekg(0);
+    // 偏移和度数、其余按顶点索引的数组、随机访问的数据
+    CSR* offsets[] = {&forward_offsets_,         &backward_offsets_,
+                      &forward_segment_offsets_, &backward_segment_offsets_,
+                      &forward_degrees_,         &backward_degrees_};
+    CSR* index[] = {&vertex_labels_, &node_offsets_, &node_index_};
+    CSR* data[] = {&forward_neighbors_, &backward_neighbors_,
+                   &forward_segments_, &backward_segments_, &node_strings_};
+    auto is_hot = [&](const CSR* csr) {
+        // 查询路径上的拓扑段，不含节点字典
+        return csr != &node_offsets_ && csr != &node_index_ &&
+               csr != &node_strings_;
+    };
+    auto is_data = [&](const CSR* csr) {
+        return std::find(std::begin(data), std::end(data), csr) !=
+               std::end(data);
+    };
+    std::vector<CSR*> sections;
+    auto add = [&](std::span<CSR* const> group) {
+        for (CSR* csr : group) {
+            if (csr->data && csr->size > 0)
+                sections.push_back(csr);
+        }
+    };
+    add(offsets);
+    add(index);
+    add(data);
 
-    while (std::getline(csv_file, line)) {
-        std::istringstream iss(line);
-        std::string start_id, end_id;
-        if (std::getline(iss, start_id, ',') &&
-            std::getline(iss, end_id, ',') &&
-            std::getline(iss, start_id, ',') &&
-            std::getline(iss, end_id, ',')) {
+    if (options.copy_to_huge_pages) {
+        std::vector<WarmupRange> ranges;
+        std::vector<CSR*> copied;
+        for (CSR* csr : sections) {
+            if (!is_hot(csr))
+                continue;
+            size_t mapped;
+            uint8_t* copy = allocateHugePages(csr->size, mapped);
+            huge_copies_.push_back({copy, mapped});
+            ranges.push_back({csr->data, copy, csr->size});
+            copied.push_back(csr);
+        }
+        warmRanges(ranges, threads);
+        for (size_t i = 0; i < copied.size(); ++i) {
+            UnmapFile(*copied[i]);
+            *copied[i] = {-1, ranges[i].dst, ranges[i].size, false};
+            warmup_.copied_bytes += ranges[i].size;
+        }
+    }
 
-            uint32_t src = str_to_id[start_id];
-            uint32_t dst = str_to_id[end_id];
+    for (CSR* csr : sections) {
+        if (options.huge_pages)
+            adviseRange(csr->data, csr->size, MADV_HUGEPAGE);
+        if (options.advise)
+            adviseRange(csr->data, csr->size,
+                        is_data(csr) ? MADV_RANDOM : MADV_WILLNEED);
+    }
 
-            // 写入边
-            edges_out.write(reinterpret_cast<const char*>(&src), sizeof(src));
-            edges_out.write(reinterpret_cast<const char*>(&dst), sizeof(dst));
+    bool touch = options.prefault == Prefault::kParallel ||
+                 (options.prefault == Prefault::kPopulate &&
+                  !graph_file_.IsOpen());
+    if (touch) {
+        std::vector<WarmupRange> ranges;
+        for (CSR* csr : sections) {
+            if (options.copy_to_huge_pages && is_hot(csr))
+                continue;
+            ranges.push_back({csr->data, nullptr, csr->size});
+            warmup_.prefaulted_bytes += csr->size;
         }
+        warmRanges(ranges, threads);
     }
-    edges_out.close();
 
-    // 第五步：构建正向 CSR（使用外部排序）
-    std::string edges_sorted = base_dir + "/edges_sorted.bin";
-    sort_cmd = "sort -k1,1 -k2,2 " + edges_temp + " -o " + edges_sorted;
-    if (system(sort_cmd.c_str()) != 0) {
-        throw std::runtime_error("Failed to sort edges");
+    if (options.lock_offsets) {
+        for (const CSR* csr : offsets) {
+            if (csr->data && csr->size > 0 && mlock(csr->data, csr->size) == 0)
+                warmup_.locked_bytes += csr->size;
+        }
     }
 
-    // 计算 offsets
-    std::vector<uint32_t> forward_offsets(node_count_ + 1, 0);
-    std::ifstream edges_sorted_in(edges_sorted, std::ios::binary);
+    warmup_.seconds += std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+}
 
-    uint32_t current_src = 0;
+std::string GraphStorage::GraphFilePath() const {
+    return graph_file_.IsOpen() ? base_dir_ + kGraphFileName : std::string();
+}
+
+void GraphStorage::VerifyChecksums() const {
+    if (graph_file_.IsOpen())
+        graph_file_.Verify();
+}
+
+void GraphStorage::MapNodeDictionary() {
+    MapFile(base_dir_ + "/node_strings.bin", node_strings_, true);
+    MapFile(base_dir_ + "/node_offsets.bin", node_offsets_, true);
+    MapFile(base_dir_ + "/node_index.bin", node_index_, true);
+    node_dict_ = StringDictionary(node_strings_.data, node_strings_.size,
+                                  node_offsets_.data, node_offsets_.size,
+                                  node_index_.data, node_index_.size);
+    node_count_ = node_dict_.Size();
+}
+
+// 旧目录只有逐条记录的 id_to_str.bin，一次性转换为字典格式
+void GraphStorage::ConvertLegacyNodeIds() {
+    std::ifstream in(base_dir_ + "/id_to_str.bin", std::ios::binary);
+    StringDictionaryBuilder builder(base_dir_ + "/node_strings.bin",
+                                    base_dir_ + "/node_offsets.bin");
     uint32_t count = 0;
-    while (true) {
-        uint32_t src, dst;
-        edges_sorted_in.read(reinterpret_cast<char*>(&src), sizeof(src));
-        if (edges_sorted_in.eof())
-            break;
-        edges_sorted_in.read(reinterpret_cast<char*>(&dst), sizeof(dst));
-
-        while (current_src < src) {
-            forward_offsets[current_src + 1] = count;
-            current_src++;
-        }
-        count++;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    std::string str;
+    for (uint32_t i = 0; i < count && in; ++i) {
+        uint32_t len = 0;
+        in.read(reinterpret_cast<char*>(&len), sizeof(len));
+        str.resize(len);
+        in.read(str.data(), len);
+        builder.Add(str);
     }
-    while (current_src <= node_count_) {
-        forward_offsets[current_src + 1] = count;
-        current_src++;
+    if (!in)
+        throw std::runtime_error("Corrupt node id file in " + base_dir_);
+    builder.Finish(base_dir_ + "/node_index.bin",
+                   std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void GraphStorage::MapCSRFiles() {
+    MapFile(base_dir_ + "/forward_offsets.bin", forward_offsets_, true);
+    MapFile(base_dir_ + "/forward_neighbors.bin", forward_neighbors_, true);
+    MapFile(base_dir_ + "/backward_offsets.bin", backward_offsets_, true);
+    MapFile(base_dir_ + "/backward_neighbors.bin", backward_neighbors_, true);
+    // 标签分段是后加的，旧目录没有时按无标签处理
+    if (std::filesystem::exists(base_dir_ + "/forward_segments.bin")) {
+        MapFile(base_dir_ + "/forward_segment_offsets.bin",
+                forward_segment_offsets_, true);
+        MapFile(base_dir_ + "/forward_segments.bin", forward_segments_, true);
+        MapFile(base_dir_ + "/backward_segment_offsets.bin",
+                backward_segment_offsets_, true);
+        MapFile(base_dir_ + "/backward_segments.bin", backward_segments_,
+                true);
+        MapFile(base_dir_ + "/vertex_labels.bin", vertex_labels_, true);
+    }
+    if (std::filesystem::exists(base_dir_ + "/forward_degrees.bin")) {
+        MapFile(base_dir_ + "/forward_degrees.bin", forward_degrees_, true);
+        MapFile(base_dir_ + "/backward_degrees.bin", backward_degrees_, true);
     }
+    DetectOffsetWidth();
+}
 
-    // 第六步：构建压缩的 neighbors
-    std::vector<uint8_t> forward_neighbors_data;
-    edges_sorted_in.clear();
-    edges_sorted_in.seekg(0);
+// 偏移宽度由 offsets 的长度推断：n + 1 个 uint64 或 n + 1 个 uint32（旧数据）。
+// 同时检查其余按顶点索引的数组长度，避免查询时越界
+void GraphStorage::DetectOffsetWidth() {
+    size_t entries = size_t(node_count_) + 1;
+    if (forward_offsets_.size == entries * sizeof(uint64_t))
+        offset_width_ = sizeof(uint64_t);
+    else if (forward_offsets_.size == entries * sizeof(uint32_t))
+        offset_width_ = sizeof(uint32_t);
+    else
+        throw std::runtime_error("Inconsistent CSR offsets in " + base_dir_);
 
-    uint32_t prev_src = 0;
-    std::vector<uint32_t> current_neighbors;
+    bool consistent = backward_offsets_.size == forward_offsets_.size;
+    for (const CSR* csr :
+         {&forward_segment_offsets_, &backward_segment_offsets_}) {
+        consistent &= !csr->data || csr->size == entries * offset_width_;
+    }
+    for (const CSR* csr : {&forward_degrees_, &backward_degrees_}) {
+        consistent &=
+            !csr->data || csr->size == size_t(node_count_) * sizeof(uint32_t);
+    }
+    if (!consistent)
+        throw std::runtime_error("Inconsistent CSR sections in " + base_dir_);
+}
+
+void GraphStorage::Unload() {
+    UnmapFiles();
+    vertex_label_names_.clear();
+    edge_label_names_.clear();
+    vertex_label_ids_.clear();
+    edge_label_ids_.clear();
+    node_count_ = 0;
+    edge_count_ = 0;
+}
 
-    while (true) {
-        uint32_t src, dst;
-        edges_sorted_in.read(reinterpret_cast<char*>(&src), sizeof(src));
-        if (edges_sorted_in.eof())
-            break;
-        edges_sorted_in.read(reinterpret_cast<char*>(&dst), sizeof(dst));
+void GraphStorage::UnmapFiles() {
+    UnmapFile(forward_offsets_);
+    UnmapFile(forward_neighbors_);
+    UnmapFile(backward_offsets_);
+    UnmapFile(backward_neighbors_);
+    UnmapFile(forward_segment_offsets_);
+    UnmapFile(forward_segments_);
+    UnmapFile(backward_segment_offsets_);
+    UnmapFile(backward_segments_);
+    UnmapFile(forward_degrees_);
+    UnmapFile(backward_degrees_);
+    UnmapFile(vertex_labels_);
+    UnmapFile(node_strings_);
+    UnmapFile(node_offsets_);
+    UnmapFile(node_index_);
+    graph_file_.Close();
+    for (const auto& [copy, size] : huge_copies_) {
+        munmap(copy, size);
+    }
+    huge_copies_.clear();
+    node_dict_ = StringDictionary();
+}
+
+// 归并有序边流，同时构建 offsets、压缩的 neighbors、度数和按边标签的分段。
+// offsets 为 uint64 字节偏移，邻居数据可超过 4 GiB。
+// 五个输出都按顶点顺序生成，逐个顶点编码后经缓冲直接写出，
+// 内存只有 buffer_bytes 的写缓冲和当前顶点的邻居
+void GraphStorage::WriteCSR(ExternalSorter<EdgeRecord>& sorter,
+                            const std::string& direction,
+                            size_t buffer_bytes) {
+    std::string prefix = base_dir_ + "/" + direction;
+    // 邻居数据占一半缓冲，其余四个按顶点索引的数组平分另一半
+    size_t small_buffer = buffer_bytes / 8;
+    BufferedFileWriter offsets(prefix + "_offsets.bin", small_buffer);
+    BufferedFileWriter neighbors(prefix + "_neighbors.bin", buffer_bytes / 2);
+    BufferedFileWriter degrees(prefix + "_degrees.bin", small_buffer);
+    BufferedFileWriter segment_offsets(prefix + "_segment_offsets.bin",
+                                       small_buffer);
+    BufferedFileWriter segments(prefix + "_segments.bin", small_buffer);
 
-        if (src != prev_src) {
+    std::vector<uint32_t> current_neighbors;
+    std::vector<LabelSegment> current_segments;
+    std::vector<uint8_t> encoded;
+    uint64_t neighbor_bytes = 0;
+    uint64_t segment_count = 0;
+    uint32_t current_src = 0;
+    offsets.Put<uint64_t>(0);
+    segment_offsets.Put<uint64_t>(0);
+
+    // 写出 current_src 的邻居表，之后到 next_src 之前的顶点没有边
+    auto flush_neighbors = [&](uint32_t next_src) {
+        while (current_src < next_src) {
             if (!current_neighbors.empty()) {
-                auto compressed = CompressNeighbors(current_neighbors);
-                forward_neighbors_data.insert(forward_neighbors_data.end(),
-                                              compressed.begin(),
-                                              compressed.end());
-                current_neighbors.clear();
+                FillResumePoints(current_neighbors, codec_,
+                                 current_segments.begin(),
+                                 current_segments.end());
+                encoded.clear();
+                EncodeNeighbors(current_neighbors, codec_, encoded);
+                neighbors.Write(encoded.data(), encoded.size());
+                segments.Write(current_segments.data(),
+                               current_segments.size() * sizeof(LabelSegment));
+                neighbor_bytes += encoded.size();
+                segment_count += current_segments.size();
             }
-            prev_src = src;
+            degrees.Put<uint32_t>(current_neighbors.size());
+            offsets.Put(neighbor_bytes);
+            segment_offsets.Put(segment_count);
+            current_neighbors.clear();
+            current_segments.clear();
+            current_src++;
+        }
+    };
+
+    sorter.Merge([&](const EdgeRecord& edge) {
+        if (edge.src != current_src)
+            flush_neighbors(edge.src);
+        if (current_segments.empty() ||
+            current_segments.back().label != edge.label ||
+            current_segments.back().count == kMaxSegmentLength) {
+            current_segments.push_back({edge.label, 0, 0, 0, 0, 0});
+        }
+        current_segments.back().count++;
+        current_neighbors.push_back(edge.dst);
+    });
+    flush_neighbors(node_count_);
+
+    offsets.Close();
+    neighbors.Close();
+    degrees.Close();
+    segment_offsets.Close();
+    segments.Close();
+}
+
+// labels.bin：顶点标签表和边标签表，各为 [uint32 count]([uint32 len][bytes])*
+void GraphStorage::WriteLabels(const std::vector<uint16_t>& vertex_labels) {
+    WriteBinaryFile(base_dir_ + "/vertex_labels.bin", vertex_labels.data(),
+                    vertex_labels.size() * sizeof(uint16_t));
+
+    std::ofstream out(base_dir_ + "/labels.bin", std::ios::binary);
+    for (const auto* names : {&vertex_label_names_, &edge_label_names_}) {
+        uint32_t count = names->size();
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (const auto& name : *names) {
+            uint32_t len = name.size();
+            out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            out.write(name.data(), len);
         }
-        current_neighbors.push_back(dst);
     }
-    if (!current_neighbors.empty()) {
-        auto compressed = CompressNeighbors(current_neighbors);
-        forward_neighbors_data.insert(forward_neighbors_data.end(),
-                                      compressed.begin(), compressed.end());
+}
+
+void GraphStorage::ReadLabels() {
+    std::string path = base_dir_ + "/labels.bin";
+    if (!std::filesystem::exists(path))
+        return;
+    auto data = ReadBinaryFile(path);
+    ParseLabels(data);
+}
+
+void GraphStorage::ParseLabels(std::span<const uint8_t> data) {
+    if (data.empty())
+        return;
+    size_t pos = 0;
+    auto read_u32 = [&]() {
+        uint32_t value;
+        if (data.size() - pos < sizeof(value))
+            throw std::runtime_error("Corrupt label dictionary in " +
+                                     base_dir_);
+        std::memcpy(&value, data.data() + pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    };
+    for (auto* names : {&vertex_label_names_, &edge_label_names_}) {
+        uint32_t count = read_u32();
+        if (count > GraphStorage::kNoLabel)
+            throw std::runtime_error("Corrupt label dictionary in " +
+                                     base_dir_);
+        names->resize(count);
+        for (auto& name : *names) {
+            uint32_t len = read_u32();
+            if (data.size() - pos < len)
+                throw std::runtime_error("Corrupt label dictionary in " +
+                                         base_dir_);
+            name.assign(reinterpret_cast<const char*>(data.data() + pos), len);
+            pos += len;
+        }
     }
+    for (uint16_t i = 0; i < vertex_label_names_.size(); ++i) {
+        vertex_label_ids_.emplace(vertex_label_names_[i], i);
+    }
+    for (uint16_t i = 0; i < edge_label_names_.size(); ++i) {
+        edge_label_ids_.emplace(edge_label_names_[i], i);
+    }
+}
 
-    // 第七步：保存数据
-    WriteBinaryFile(base_dir + "/forward_offsets.bin", forward_offsets.data(),
-                    forward_offsets.size() * sizeof(uint32_t));
-    WriteBinaryFile(base_dir + "/forward_neighbors.bin",
-                    forward_neighbors_data.data(),
-                    forward_neighbors_data.size());
+void GraphStorage::BuildFromCSV(const std::string& csv_path,
+                                const BuildOptions& options) {
+    const std::string& base_dir = base_dir_;
+    std::filesystem::create_directories(base_dir);
+    Unload();
+
+    unsigned threads = options.threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
 
-    // 保存节点映射
-    std::ofstream id_file(base_dir + "/id_to_str.bin", std::ios::binary);
-    uint32_t count = id_to_str.size();
-    id_file.write(reinterpret_cast<const char*>(&count), sizeof(count));
-    for (const auto& str : id_to_str) {
-        uint32_t len = str.size();
-        id_file.write(reinterpret_cast<const char*>(&len), sizeof(len));
-        id_file.write(str.c_str(), len);
+    CsvReader csv(csv_path, options.csv_has_header);
+    std::atomic<uint64_t> edge_count{0};
+    LabelAssigner vertex_label_ids(threads);
+    LabelAssigner edge_label_ids(threads);
+    NodeInterner nodes(base_dir + "/nodes", options.dictionary_memory_budget);
+    PendingEdges pending(base_dir + "/pending", nodes.Partitions());
+
+    // 正向边和反向边分别送入外部排序，反向边以 (dst, src) 记录，
+    // 排序后即为入边 CSR 的顺序
+    size_t edge_budget = options.sort_memory_budget / 2;
+    ExternalSorter<EdgeRecord> forward_sorter(base_dir + "/edges_forward",
+                                              edge_budget, threads);
+    ExternalSorter<EdgeRecord> backward_sorter(base_dir + "/edges_backward",
+                                               edge_budget, threads);
+    auto emit = [&](std::vector<EdgeRecord>& edges) {
+        forward_sorter.Add(edges.data(), edges.size());
+        for (auto& edge : edges) {
+            std::swap(edge.src, edge.dst);
+        }
+        backward_sorter.Add(edges.data(), edges.size());
+        edges.clear();
+    };
+
+    // 第一步：单遍并行解析，节点和标签在解析时直接编号，边随即送入排序。
+    // 端点所在分区已溢写的边暂存到待解析的分桶
+    csv.ForEachBatch(threads, [&](unsigned worker, const EdgeFields* rows,
+                                  size_t n) {
+        std::vector<EdgeRecord> edges;
+        edges.reserve(n);
+        PendingEdges::Batch batch;
+        for (size_t i = 0; i < n; ++i) {
+            const EdgeFields& row = rows[i];
+            PendingEdge edge;
+            edge.label = edge_label_ids.Assign(worker, row.edge_label);
+            edge.src_label = vertex_label_ids.Assign(worker, row.start_label);
+            edge.dst_label = vertex_label_ids.Assign(worker, row.end_label);
+            edge.src = nodes.Intern(row.start_id, edge.src_label);
+            edge.dst = nodes.Intern(row.end_id, edge.dst_label);
+            if (edge.src == NodeInterner::kPending ||
+                edge.dst == NodeInterner::kPending) {
+                edge.src_id = row.start_id;
+                edge.dst_id = row.end_id;
+                batch.Add(nodes, edge);
+            } else {
+                edges.push_back({edge.src, edge.dst, edge.label});
+            }
+        }
+        emit(edges);
+        pending.Append(batch);
+        edge_count += n;
+    });
+    vertex_label_ids.MoveTo(vertex_label_names_, vertex_label_ids_);
+    edge_label_ids.MoveTo(edge_label_names_, edge_label_ids_);
+
+    // 第二步：逐个载入有待解析边的分区，解析落在该分区的端点。
+    // 边按未解析端点中最小的分区分桶，另一端的分区更大，尚未处理。
+    // 这一阶段不再自动溢写，保证载入的分区留在内存中
+    nodes.SetAutoSpill(false);
+    for (unsigned p = 0; p < nodes.Partitions(); ++p) {
+        if (pending.Empty(p))
+            continue;
+        nodes.Reload(p);
+        std::vector<EdgeRecord> edges;
+        PendingEdges::Batch batch;
+        pending.ForEach(p, [&](PendingEdge& edge) {
+            if (edge.src == NodeInterner::kPending &&
+                nodes.PartitionOf(edge.src_id) == p)
+                edge.src = nodes.Intern(edge.src_id, edge.src_label);
+            if (edge.dst == NodeInterner::kPending &&
+                nodes.PartitionOf(edge.dst_id) == p)
+                edge.dst = nodes.Intern(edge.dst_id, edge.dst_label);
+            if (edge.src == NodeInterner::kPending ||
+                edge.dst == NodeInterner::kPending) {
+                batch.Add(nodes, edge);
+            } else {
+                edges.push_back({edge.src, edge.dst, edge.label});
+            }
+            if (edges.size() >= kResolveBatch)
+                emit(edges);
+            if (batch.Bytes() >= kResolveBatch)
+                pending.Append(batch);
+        });
+        emit(edges);
+        pending.Append(batch);
+        nodes.Spill(p);
+    }
+
+    // 第三步：按 ID 写出节点字典并构建完美哈希，同时生成顶点标签列。
+    // 同一顶点的标签不一致时 Intern 已报错
+    std::vector<uint16_t> vertex_labels(nodes.Size(), kNoLabel);
+    {
+        std::vector<uint32_t> lengths(nodes.Size());
+        nodes.ForEach([&](uint32_t id, std::string_view str, uint16_t) {
+            lengths[id] = str.size();
+        });
+        StringDictionaryBuilder builder(base_dir + "/node_strings.bin",
+                                        base_dir + "/node_offsets.bin",
+                                        lengths);
+        nodes.ForEach([&](uint32_t id, std::string_view str, uint16_t label) {
+            builder.Set(id, str);
+            vertex_labels[id] = label;
+        });
+        builder.Finish(base_dir + "/node_index.bin", threads);
     }
+    std::filesystem::remove(base_dir + "/id_to_str.bin");
+    std::filesystem::remove(base_dir + "/vertex_order.bin");
+    MapNodeDictionary();
+    edge_count_ = edge_count;
+
+    // 第四步：构建并保存正反两个方向的 CSR
+    codec_ = options.codec;
+    vertex_order_ = options.vertex_order;
+    WriteFormatHeader();
+    WriteCSR(forward_sorter, "forward", options.csr_write_buffer);
+    WriteCSR(backward_sorter, "backward", options.csr_write_buffer);
+    WriteLabels(vertex_labels);
 
-    // 更新内部状态
-    str_to_id_ = std::move(str_to_id);
-    id_to_str_ = std::move(id_to_str);
+    // 映射新生成的 CSR
+    MapCSRFiles();
 
-    // 清理临时文件
-    std::remove(nodes_temp.c_str());
-    std::remove(edges_temp.c_str());
-    std::remove(edges_sorted.c_str());
+    // 第五步（可选）：在建好的图上计算新编号，按新编号重写
+    if (vertex_order_ != VertexOrder::kNone)
+        Reorder(options, threads);
+
+    // 第六步：打包为单文件容器，按加载策略预热
+    PackGraphFile();
+    ApplyMappingPolicy();
+}
+
+// 重编号：CSR 的边经 perm 映射后重新排序写出，节点字典和顶点标签列按新 ID
+// 重写，perm[分配时的 ID] = 新 ID 保存在 vertex_order.bin。
+// 新文件写完前旧文件仍在映射中，字典先写到临时文件，解除映射后再替换
+void GraphStorage::Reorder(const BuildOptions& options, unsigned threads) {
+    std::vector<uint32_t> perm =
+        ComputeVertexOrder(*this, vertex_order_, options.gorder_window);
+
+    size_t edge_budget = options.sort_memory_budget / 2;
+    ExternalSorter<EdgeRecord> forward_sorter(base_dir_ + "/reorder_forward",
+                                              edge_budget, threads);
+    ExternalSorter<EdgeRecord> backward_sorter(
+        base_dir_ + "/reorder_backward", edge_budget, threads);
+    std::atomic<uint32_t> next_vertex{0};
+    RunInParallel(threads, [&](unsigned) {
+        constexpr uint32_t kVertexBatch = 1024;
+        std::vector<EdgeRecord> edges;
+        for (uint32_t first = next_vertex.fetch_add(kVertexBatch);
+             first < node_count_;
+             first = next_vertex.fetch_add(kVertexBatch)) {
+            uint32_t last = std::min(node_count_, first + kVertexBatch);
+            for (uint32_t v = first; v < last; ++v) {
+                NeighborRange neighbors = OutNeighbors(v);
+                for (const auto& segment : OutSegments(v)) {
+                    neighbors.ForEachInSegment(
+                        segment, 0, segment.count, [&](uint32_t u) {
+                            edges.push_back({perm[v], perm[u], segment.label});
+                            return true;
+                        });
+                }
+            }
+            forward_sorter.Add(edges.data(), edges.size());
+            for (auto& edge : edges) {
+                std::swap(edge.src, edge.dst);
+            }
+            backward_sorter.Add(edges.data(), edges.size());
+            edges.clear();
+        }
+    });
+
+    std::vector<uint16_t> vertex_labels(node_count_);
+    std::vector<uint32_t> lengths(node_count_);
+    for (uint32_t v = 0; v < node_count_; ++v) {
+        vertex_labels[perm[v]] = VertexLabel(v);
+        lengths[perm[v]] = node_dict_.Get(v).size();
+    }
+    {
+        StringDictionaryBuilder builder(base_dir_ + "/node_strings.tmp",
+                                        base_dir_ + "/node_offsets.tmp",
+                                        lengths);
+        for (uint32_t v = 0; v < node_count_; ++v) {
+            builder.Set(perm[v], node_dict_.Get(v));
+        }
+        builder.Finish(base_dir_ + "/node_index.tmp", threads);
+    }
+    WriteBinaryFile(base_dir_ + "/vertex_order.bin", perm.data(),
+                    perm.size() * sizeof(uint32_t));
+
+    UnmapFiles();
+    for (const char* name : {"node_strings", "node_offsets", "node_index"}) {
+        std::filesystem::rename(base_dir_ + "/" + name + ".tmp",
+                                base_dir_ + "/" + name + ".bin");
+    }
+    WriteCSR(forward_sorter, "forward", options.csr_write_buffer);
+    WriteCSR(backward_sorter, "backward", options.csr_write_buffer);
+    WriteLabels(vertex_labels);
+    MapNodeDictionary();
+    MapCSRFiles();
 }
 
 uint32_t GraphStorage::OutDegree(uint32_t node_id) const {
     if (node_id >= node_count_)
         return 0;
-    const uint32_t* offsets =
-        reinterpret_cast<const uint32_t*>(forward_offsets_.data);
-    return offsets[node_id + 1] - offsets[node_id];
+    if (forward_degrees_.data)
+        return reinterpret_cast<const uint32_t*>(
+            forward_degrees_.data)[node_id];
+    return OutNeighbors(node_id).size();
 }
 
 uint32_t GraphStorage::InDegree(uint32_t node_id) const {
     if (node_id >= node_count_)
         return 0;
-    const uint32_t* offsets =
-        reinterpret_cast<const uint32_t*>(backward_offsets_.data);
-    return offsets[node_id + 1] - offsets[node_id];
+    if (backward_degrees_.data)
+        return reinterpret_cast<const uint32_t*>(
+            backward_degrees_.data)[node_id];
+    return InNeighbors(node_id).size();
 }
 
-std::vector<uint32_t> GraphStorage::GetOutNeighbors(uint32_t node_id) const {
+NeighborRange GraphStorage::OutNeighbors(uint32_t node_id) const {
     if (node_id >= node_count_)
         return {};
 
-    const uint32_t* offsets =
-        reinterpret_cast<const uint32_t*>(forward_offsets_.data);
-    uint32_t start = offsets[node_id];
-    uint32_t end = offsets[node_id + 1];
+    uint64_t start = OffsetAt(forward_offsets_, node_id);
+    uint64_t end = OffsetAt(forward_offsets_, node_id + 1);
+    return NeighborRange(forward_neighbors_.data + start, end - start,
+                         codec_);
+}
 
-    const uint8_t* neighbors_data = forward_neighbors_.data + start;
-    size_t size = end - start;
+NeighborRange GraphStorage::InNeighbors(uint32_t node_id) const {
+    if (node_id >= node_count_)
+        return {};
 
-    return DecompressNeighbors(neighbors_data, size);
+    uint64_t start = OffsetAt(backward_offsets_, node_id);
+    uint64_t end = OffsetAt(backward_offsets_, node_id + 1);
+    return NeighborRange(backward_neighbors_.data + start, end - start,
+                         codec_);
+}
+
+std::vector<uint32_t> GraphStorage::GetOutNeighbors(uint32_t node_id) const {
+    std::vector<uint32_t> result;
+    OutNeighbors(node_id).DecodeInto(result);
+    return result;
 }
 
 std::vector<uint32_t> GraphStorage::GetInNeighbors(uint32_t node_id) const {
-    if (node_id >= node_count_)
-        return {};
+    std::vector<uint32_t> result;
+    InNeighbors(node_id).DecodeInto(result);
+    return result;
+}
 
-    // 按需加载反向 CSR
-    if (!backward_offsets_.is_mapped) {
-        std::string base_dir = std::filesystem::path("graph_data").string();
-        const_cast<GraphStorage*>(this)->MapFile(
-            base_dir + "/backward_offsets.bin",
-            const_cast<CSR&>(backward_offsets_), true);
-        const_cast<GraphStorage*>(this)->MapFile(
-            base_dir + "/backward_neighbors.bin",
-            const_cast<CSR&>(backward_neighbors_), true);
-    }
+bool GraphStorage::HasLabels() const {
+    return forward_segments_.data && vertex_labels_.data;
+}
+
+uint16_t GraphStorage::VertexLabel(uint32_t node_id) const {
+    if (node_id >= node_count_ || !vertex_labels_.data)
+        return kNoLabel;
+    return reinterpret_cast<const uint16_t*>(vertex_labels_.data)[node_id];
+}
+
+uint16_t GraphStorage::VertexLabelId(std::string_view label) const {
+    auto it = vertex_label_ids_.find(label);
+    return it == vertex_label_ids_.end() ? kNoLabel : it->second;
+}
 
-    const uint32_t* offsets =
-        reinterpret_cast<const uint32_t*>(backward_offsets_.data);
-    uint32_t start = offsets[node_id];
-    uint32_t end = offsets[node_id + 1];
+uint16_t GraphStorage::EdgeLabelId(std::string_view label) const {
+    auto it = edge_label_ids_.find(label);
+    return it == edge_label_ids_.end() ? kNoLabel : it->second;
+}
 
-    const uint8_t* neighbors_data = backward_neighbors_.data + start;
-    size_t size = end - start;
+std::span<const LabelSegment> GraphStorage::OutSegments(
+    uint32_t node_id) const {
+    if (node_id >= node_count_ || !forward_segments_.data)
+        return {};
+    const auto* segments =
+        reinterpret_cast<const LabelSegment*>(forward_segments_.data);
+    return {segments + OffsetAt(forward_segment_offsets_, node_id),
+            segments + OffsetAt(forward_segment_offsets_, node_id + 1)};
+}
 
-    return DecompressNeighbors(neighbors_data, size);
+std::span<const LabelSegment> GraphStorage::InSegments(
+    uint32_t node_id) const {
+    if (node_id >= node_count_ || !backward_segments_.data)
+        return {};
+    const auto* segments =
+        reinterpret_cast<const LabelSegment*>(backward_segments_.data);
+    return {segments + OffsetAt(backward_segment_offsets_, node_id),
+            segments + OffsetAt(backward_segment_offsets_, node_id + 1)};
 }
 
-uint32_t GraphStorage::StringToId(const std::string& str_id) const {
-    auto it = str_to_id_.find(str_id);
-    if (it == str_to_id_.end())
-        return static_cast<uint32_t>(-1);
-    return it->second;
+uint32_t GraphStorage::StringToId(std::string_view str_id) const {
+    return node_dict_.Find(str_id);
 }
 
-std::string GraphStorage::IdToString(uint32_t id) const {
-    if (id >= id_to_str_.size())
-        return "";
-    return id_to_str_[id];
+std::string_view GraphStorage::IdToString(uint32_t id) const {
+    if (id >= node_count_)
+        return {};
+    return node_dict_.Get(id);
 }
 
 }  // namespace hackathon
@@ -9,32 +9,154 @@
 #include <algorithm>
 #include <cstdint>
 #include <filesystem>
+#include <span>
 #include <fstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
+#include "graph_file.h"
+#include "neighbor_codec.h"
+#include "string_dict.h"
+#include "vertex_order.h"
 
 namespace hackathon {
 
+struct EdgeRecord;
+template <typename Record>
+class ExternalSorter;
+
+struct BuildOptions {
+    size_t sort_memory_budget = size_t(1) << 30;  // 外部排序内存预算（字节）
+    // 节点字符串表的内存预算，超出后按分区溢写到磁盘
+    size_t dictionary_memory_budget = size_t(1) << 30;
+    // 写 CSR 时各输出文件的缓冲总大小，邻居表边编码边写出，
+    // 除当前顶点的邻居外不在内存中保留整张表
+    size_t csr_write_buffer = size_t(64) << 20;
+    unsigned threads = 0;  // 0 表示使用全部硬件线程
+    bool csv_has_header = true;  // CSV 首行是否为表头
+    NeighborCodec codec = NeighborCodec::kStreamVByte;  // 邻居表编码
+    // 建好后按该方式重编号顶点，使相关的顶点 ID 相近，邻居表 delta 更小
+    VertexOrder vertex_order = VertexOrder::kNone;
+    unsigned gorder_window = 5;
+};
+
+// 加载后如何把映射的段调入内存
+enum class Prefault {
+    kNone,      // 查询时按需缺页
+    kPopulate,  // mmap 时带 MAP_POPULATE，由内核读入整个文件
+    kParallel,  // 映射后多线程逐页触碰
+};
+
+// 加载（包括 BuildFromCSV 结束时）对映射段采取的策略，默认全部关闭
+struct LoadOptions {
+    Prefault prefault = Prefault::kNone;
+    unsigned threads = 0;  // 预热和复制用的线程数，0 表示全部硬件线程
+    // 按段的访问方式 madvise：按顶点索引的数组 WILLNEED，
+    // 邻居数据和节点字符串 RANDOM（随机访问，关闭预读）
+    bool advise = false;
+    bool huge_pages = false;  // 对文件映射 MADV_HUGEPAGE，需内核支持文件 THP
+    // mlock 偏移和度数数组，超出 RLIMIT_MEMLOCK 时跳过
+    bool lock_offsets = false;
+    // 把查询用到的拓扑段复制到 2 MB 对齐、MADV_HUGEPAGE 的匿名内存，
+    // 不依赖文件 THP，代价是常驻一份拷贝
+    bool copy_to_huge_pages = false;
+};
+
+// 最近一次加载时映射策略的执行结果
+struct WarmupStats {
+    double seconds = 0;  // 预热耗时，包括 MAP_POPULATE 的映射
+    uint64_t prefaulted_bytes = 0;
+    uint64_t locked_bytes = 0;
+    uint64_t copied_bytes = 0;
+};
+
+// 支持以 string_view 直接查找 std::string 键
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view str) const {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+using LabelIdMap =
+    std::unordered_map<std::string, uint16_t, StringHash, std::equal_to<>>;
+
 class GraphStorage {
    public:
-    GraphStorage(const std::string& base_dir);
+    static constexpr uint16_t kNoLabel = 0xFFFF;
+
+    GraphStorage(const std::string& base_dir,
+                 const LoadOptions& load_options = {});
     ~GraphStorage();
 
-    void BuildFromCSV(const std::string& csv_path);
+    // 之后的 BuildFromCSV 按新策略映射，已有的映射不变。
+    // 启动时先重建再服务的调用方用它避免对将被替换的旧图预热
+    void SetLoadOptions(const LoadOptions& options) {
+        load_options_ = options;
+    }
+
+    void BuildFromCSV(const std::string& csv_path,
+                      const BuildOptions& options = {});
+    // 邻居数，O(1)；没有度数数组的旧数据按邻居表表头或扫描计算
     uint32_t OutDegree(uint32_t node_id) const;
     uint32_t InDegree(uint32_t node_id) const;
+    NeighborRange OutNeighbors(uint32_t node_id) const;
+    NeighborRange InNeighbors(uint32_t node_id) const;
     std::vector<uint32_t> GetOutNeighbors(uint32_t node_id) const;
     std::vector<uint32_t> GetInNeighbors(uint32_t node_id) const;
-    uint32_t StringToId(const std::string& str_id) const;
-    std::string IdToString(uint32_t id) const;
+    // 节点字符串 ID 与内部 ID 互转，字典整体 mmap，加载时不逐条读入。
+    // IdToString 返回的视图在 GraphStorage 析构或重建后失效
+    uint32_t StringToId(std::string_view str_id) const;
+    std::string_view IdToString(uint32_t id) const;
 
     uint32_t NodeCount() const { return node_count_; }
 
     uint64_t EdgeCount() const { return edge_count_; }
 
+    NeighborCodec Codec() const { return codec_; }
+
+    VertexOrder Order() const { return vertex_order_; }
+
+    const WarmupStats& Warmup() const { return warmup_; }
+
+    // 单文件容器的路径，构建后生成的附加数据据此放在同一目录；
+    // 旧的散文件目录返回空串
+    std::string GraphFilePath() const;
+    // 单文件容器的头部 CRC，附加数据用它确认对应的是当前这份图
+    uint32_t GraphFileChecksum() const { return graph_file_.Checksum(); }
+
+    // 是否有标签数据；标签支持之前构建的旧目录没有，需重建才能按标签查询
+    bool HasLabels() const;
+
+    // 标签按首次出现的顺序编码为小整数 ID，未知标签返回 kNoLabel
+    uint16_t VertexLabel(uint32_t node_id) const;
+    uint16_t VertexLabelId(std::string_view label) const;
+    uint16_t EdgeLabelId(std::string_view label) const;
+
+    // 按边标签切分的出/入邻居段，与 OutNeighbors/InNeighbors 返回的
+    // NeighborRange 配合 ForEachInSegment 使用
+    std::span<const LabelSegment> OutSegments(uint32_t node_id) const;
+    std::span<const LabelSegment> InSegments(uint32_t node_id) const;
+
+    // 软件预取，批量扩展出边时提前若干个顶点调用，分两级：
+    // PrefetchOutIndex 取 offsets（labels 为 true 时连同分段偏移）；
+    // 之后 PrefetchOutData 取邻居数据开头（和分段），它要读 offsets，
+    // 应在前一级预取到达后再调
+    void PrefetchOutIndex(uint32_t node_id, bool labels) const;
+    void PrefetchOutData(uint32_t node_id, bool labels) const;
+
+    // 校验单文件容器中所有段的 CRC32C，数据损坏时抛出异常。
+    // 耗时与数据量成正比，加载时不做；旧的散文件目录没有校验和，直接返回
+    void VerifyChecksums() const;
+
    private:
+    static constexpr uint64_t kCacheLine = 64;
+    // 预取邻居数据时最多取开头的几个缓存行，更长的表解码时由硬件顺序预取
+    static constexpr uint64_t kPrefetchLines = 2;
+
     struct CSR {
         int fd;
         uint8_t* data;
@@ -42,25 +164,116 @@ class GraphStorage {
         bool is_mapped;
     };
 
-    std::unordered_map<std::string, uint32_t> str_to_id_;
-    std::vector<std::string> id_to_str_;
+    std::string base_dir_;
     mutable CSR forward_offsets_;
     mutable CSR forward_neighbors_;
     mutable CSR backward_offsets_;
     mutable CSR backward_neighbors_;
+    mutable CSR forward_segment_offsets_;
+    mutable CSR forward_segments_;
+    mutable CSR backward_segment_offsets_;
+    mutable CSR backward_segments_;
+    mutable CSR forward_degrees_;
+    mutable CSR backward_degrees_;
+    mutable CSR vertex_labels_;
+    mutable CSR node_strings_;
+    mutable CSR node_offsets_;
+    mutable CSR node_index_;
+    GraphFile graph_file_;
+    // copy_to_huge_pages 时各段的匿名内存副本（起点，映射长度）
+    std::vector<std::pair<uint8_t*, size_t>> huge_copies_;
+    LoadOptions load_options_;
+    WarmupStats warmup_;
+    StringDictionary node_dict_;
+    std::vector<std::string> vertex_label_names_;
+    std::vector<std::string> edge_label_names_;
+    LabelIdMap vertex_label_ids_;
+    LabelIdMap edge_label_ids_;
     uint32_t node_count_ = 0;
     uint64_t edge_count_ = 0;
+    // offsets 和 segment_offsets 的元素宽度：新数据为 8，旧数据为 4
+    size_t offset_width_ = sizeof(uint64_t);
+    NeighborCodec codec_ = NeighborCodec::kVarint;
+    VertexOrder vertex_order_ = VertexOrder::kNone;
 
+    void Load();
+    void OpenGraphFile();
+    void PackGraphFile();
+    void ApplyMappingPolicy();
+    void MapCSRFiles();
+    void DetectOffsetWidth();
+    uint64_t OffsetAt(const CSR& offsets, uint32_t index) const;
+    void PrefetchIndex(const CSR& offsets, const CSR& segment_offsets,
+                       uint32_t node_id, bool labels) const;
+    void PrefetchData(const CSR& offsets, const CSR& neighbors,
+                      const CSR& segment_offsets, const CSR& segments,
+                      uint32_t node_id, bool labels) const;
+    void MapNodeDictionary();
+    void ConvertLegacyNodeIds();
+    void Unload();
+    void UnmapFiles();
+    void Reorder(const BuildOptions& options, unsigned threads);
     void MapFile(const std::string& path, CSR& csr,
                  bool read_only = true) const;
     void UnmapFile(CSR& csr) const;
-    static std::vector<uint8_t> CompressNeighbors(
-        const std::vector<uint32_t>& neighbors);
-    static std::vector<uint32_t> DecompressNeighbors(const uint8_t* data,
-                                                     size_t size);
+    void WriteCSR(ExternalSorter<EdgeRecord>& sorter,
+                  const std::string& direction, size_t buffer_bytes);
+    void WriteLabels(const std::vector<uint16_t>& vertex_labels);
+    void ReadLabels();
+    void ParseLabels(std::span<const uint8_t> data);
+    void WriteFormatHeader();
+    void ReadFormatHeader();
     void WriteBinaryFile(const std::string& path, const void* data,
                          size_t size);
     std::vector<uint8_t> ReadBinaryFile(const std::string& path);
 };
 
+// 预取和偏移读取在扩展的内层循环中调用，定义在头文件中以便内联
+
+inline uint64_t GraphStorage::OffsetAt(const CSR& offsets,
+                                       uint32_t index) const {
+    if (offset_width_ == sizeof(uint64_t))
+        return reinterpret_cast<const uint64_t*>(offsets.data)[index];
+    return reinterpret_cast<const uint32_t*>(offsets.data)[index];
+}
+
+inline void GraphStorage::PrefetchIndex(const CSR& offsets,
+                                        const CSR& segment_offsets,
+                                        uint32_t node_id, bool labels) const {
+    if (node_id >= node_count_)
+        return;
+    __builtin_prefetch(offsets.data + size_t(node_id) * offset_width_);
+    if (labels && segment_offsets.data)
+        __builtin_prefetch(segment_offsets.data +
+                           size_t(node_id) * offset_width_);
+}
+
+inline void GraphStorage::PrefetchData(const CSR& offsets, const CSR& neighbors,
+                                       const CSR& segment_offsets,
+                                       const CSR& segments, uint32_t node_id,
+                                       bool labels) const {
+    if (node_id >= node_count_)
+        return;
+    uint64_t start = OffsetAt(offsets, node_id);
+    uint64_t bytes = std::min(OffsetAt(offsets, node_id + 1) - start,
+                              kPrefetchLines * kCacheLine);
+    for (uint64_t pos = 0; pos < bytes; pos += kCacheLine) {
+        __builtin_prefetch(neighbors.data + start + pos);
+    }
+    if (labels && segments.data)
+        __builtin_prefetch(segments.data + OffsetAt(segment_offsets, node_id) *
+                                               sizeof(LabelSegment));
+}
+
+inline void GraphStorage::PrefetchOutIndex(uint32_t node_id,
+                                           bool labels) const {
+    PrefetchIndex(forward_offsets_, forward_segment_offsets_, node_id, labels);
+}
+
+inline void GraphStorage::PrefetchOutData(uint32_t node_id,
+                                          bool labels) const {
+    PrefetchData(forward_offsets_, forward_neighbors_,
+                 forward_segment_offsets_, forward_segments_, node_id, labels);
+}
+
 }  // namespace hackathon
@@ -0,0 +1,157 @@
+// src/storage/neighbor_codec.cc
+#include "neighbor_codec.h"
+#include <array>
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+namespace hackathon {
+
+namespace {
+
+void EncodeVarint(uint32_t value, std::vector<uint8_t>& out) {
+    while (value > 0x7F) {
+        out.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+// 每个值按 1~4 字节存储，控制字节中每 2 位记录一个值的 (字节数 - 1)
+inline uint32_t ByteLength(uint32_t value) {
+    return value < (1u << 8)    ? 1
+           : value < (1u << 16) ? 2
+           : value < (1u << 24) ? 3
+                                : 4;
+}
+
+inline uint32_t VarintLength(uint32_t value) {
+    uint32_t len = 1;
+    while (value > 0x7F) {
+        value >>= 7;
+        len++;
+    }
+    return len;
+}
+
+struct ShuffleTables {
+    std::array<uint8_t, 256> length{};
+    std::array<std::array<uint8_t, 16>, 256> shuffle{};
+
+    ShuffleTables() {
+        for (int c = 0; c < 256; ++c) {
+            uint8_t src = 0;
+            for (int j = 0; j < 4; ++j) {
+                int len = ((c >> (2 * j)) & 3) + 1;
+                for (int k = 0; k < 4; ++k) {
+                    shuffle[c][4 * j + k] = k < len ? src + k : 0x80;
+                }
+                src += len;
+            }
+            length[c] = src;
+        }
+    }
+};
+
+const ShuffleTables kTables;
+
+}  // namespace
+
+void EncodeNeighbors(const std::vector<uint32_t>& neighbors,
+                     NeighborCodec codec, std::vector<uint8_t>& out) {
+    if (neighbors.empty())
+        return;
+
+    if (codec == NeighborCodec::kVarint) {
+        uint32_t prev = 0;
+        for (uint32_t val : neighbors) {
+            EncodeVarint(val - prev, out);
+            prev = val;
+        }
+        return;
+    }
+
+    uint32_t count = neighbors.size();
+    EncodeVarint(count, out);
+    size_t control = out.size();
+    out.resize(control + (count + 3) / 4, 0);
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t delta = neighbors[i] - prev;
+        prev = neighbors[i];
+        uint32_t len = ByteLength(delta);
+        out[control + i / 4] |= (len - 1) << (2 * (i % 4));
+        for (uint32_t k = 0; k < len; ++k) {
+            out.push_back(static_cast<uint8_t>(delta >> (8 * k)));
+        }
+    }
+}
+
+void FillResumePoints(const std::vector<uint32_t>& neighbors,
+                      NeighborCodec codec,
+                      std::vector<LabelSegment>::iterator first,
+                      std::vector<LabelSegment>::iterator last) {
+    uint32_t start = 0;
+    for (auto it = first; it != last; ++it) {
+        it->resume = codec == NeighborCodec::kStreamVByte ? start & ~3u : start;
+        it->skip = start - it->resume;
+        start += it->count;
+    }
+
+    // 单遍扫描，到达各段恢复点时记录字节偏移和前缀值
+    auto seg = first;
+    uint32_t byte_offset = 0;
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < neighbors.size() && seg != last; ++i) {
+        while (seg != last && seg->resume == i) {
+            seg->byte_offset = byte_offset;
+            seg->base = prev;
+            ++seg;
+        }
+        uint32_t delta = neighbors[i] - prev;
+        byte_offset += codec == NeighborCodec::kStreamVByte
+                           ? ByteLength(delta)
+                           : VarintLength(delta);
+        prev = neighbors[i];
+    }
+}
+
+const uint8_t* DecodeStreamVByte(const uint8_t* control, const uint8_t* data,
+                                 const uint8_t* end, uint32_t count,
+                                 uint32_t prev, uint32_t* out) {
+    uint32_t i = 0;
+#if defined(__SSSE3__)
+    // 每组 4 个值：一次 pshufb 展开，再做 delta 前缀和
+    __m128i base = _mm_set1_epi32(prev);
+    for (; i + 4 <= count && end - data >= 16; i += 4) {
+        uint8_t c = control[i / 4];
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        __m128i mask = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(kTables.shuffle[c].data()));
+        __m128i v = _mm_shuffle_epi8(raw, mask);
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, base);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+        base = _mm_shuffle_epi32(v, 0xFF);
+        data += kTables.length[c];
+    }
+    if (i > 0)
+        prev = out[i - 1];
+#endif
+    for (; i < count; ++i) {
+        uint32_t len = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t delta = 0;
+        for (uint32_t k = 0; k < len; ++k) {
+            delta |= static_cast<uint32_t>(data[k]) << (8 * k);
+        }
+        data += len;
+        prev += delta;
+        out[i] = prev;
+    }
+    return data;
+}
+
+}  // namespace hackathon
@@ -0,0 +1,283 @@
+// src/storage/neighbor_codec.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace hackathon {
+
+// 邻居表的磁盘编码，数值写入格式头，不可修改已有取值
+enum class NeighborCodec : uint32_t {
+    kVarint = 0,       // delta + LEB128，无格式头的旧数据
+    kStreamVByte = 1,  // [varint count][控制字节][数据字节]，delta 编码
+};
+
+inline uint32_t DecodeVarint(const uint8_t*& data) {
+    uint32_t value = 0;
+    int shift = 0;
+    while (true) {
+        uint8_t byte = *data++;
+        value |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            break;
+        shift += 7;
+    }
+    return value;
+}
+
+// 邻居表按 (边标签, 邻居) 排序后整体仍是一条 delta 流（delta 按 uint32 回绕），
+// 每个标签对应其中连续的一段或多段。段记录一个可直接开始解码的恢复点，
+// 按标签过滤时可跳过其他段而不必解码。
+struct LabelSegment {
+    uint16_t label;
+    uint16_t skip;         // 恢复点到本段首元素之间的元素数
+    uint32_t resume;       // 恢复点的元素下标，StreamVByte 按 4 个一组对齐
+    uint32_t byte_offset;  // 恢复点在数据区中的字节偏移
+    uint32_t base;         // 恢复点之前一个元素的值，0 表示从头开始
+    uint32_t count;        // 本段邻居数
+};
+
+// 单段邻居数上限，同一标签超过时切成多段。高度数顶点拆给多个线程时
+// 各部分从所在段的恢复点开始解码，不必从表头解码到自己的起点
+constexpr uint32_t kMaxSegmentLength = 1024;
+
+// 将邻居表按 codec 编码后追加到 out，邻居按段有序即可
+void EncodeNeighbors(const std::vector<uint32_t>& neighbors,
+                     NeighborCodec codec, std::vector<uint8_t>& out);
+
+// 为连续排列的各段填写 skip/resume/byte_offset/base，label 和 count 由调用方给出
+void FillResumePoints(const std::vector<uint32_t>& neighbors,
+                      NeighborCodec codec,
+                      std::vector<LabelSegment>::iterator first,
+                      std::vector<LabelSegment>::iterator last);
+
+// 从 data 解码 count 个 StreamVByte delta 值，以 prev 为前缀和起点写入 out，
+// 返回已消费数据之后的位置。end 为本邻居表数据的末尾，距末尾不足 16 字节的
+// 组用标量解码，不会越界读取。
+const uint8_t* DecodeStreamVByte(const uint8_t* control, const uint8_t* data,
+                                 const uint8_t* end, uint32_t count,
+                                 uint32_t prev, uint32_t* out);
+
+// 一个节点的压缩邻居表视图，遍历时原地解码，不分配内存。
+// 视图指向 mmap 的数据，GraphStorage 析构或重建后失效。
+class NeighborRange {
+   public:
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint32_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint32_t*;
+        using reference = uint32_t;
+
+        Iterator() = default;
+
+        uint32_t operator*() const { return value_; }
+
+        Iterator& operator++() {
+            cur_ = next_;
+            if (cur_ < end_)
+                Decode();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return cur_ == other.cur_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return cur_ != other.cur_;
+        }
+
+       private:
+        friend class NeighborRange;
+
+        Iterator(NeighborCodec codec, const uint8_t* control,
+                 const uint8_t* pos, const uint8_t* end)
+            : codec_(codec), control_(control), cur_(pos), next_(pos),
+              end_(end) {
+            if (cur_ < end_)
+                Decode();
+        }
+
+        void Decode() {
+            if (codec_ == NeighborCodec::kVarint) {
+                value_ += DecodeVarint(next_);
+                return;
+            }
+            uint32_t shift = 2 * (index_ & 3);
+            uint32_t len = ((control_[index_ >> 2] >> shift) & 3) + 1;
+            uint32_t delta = 0;
+            for (uint32_t i = 0; i < len; ++i) {
+                delta |= static_cast<uint32_t>(next_[i]) << (8 * i);
+            }
+            next_ += len;
+            index_++;
+            value_ += delta;
+        }
+
+        NeighborCodec codec_ = NeighborCodec::kVarint;
+        const uint8_t* control_ = nullptr;
+        const uint8_t* cur_ = nullptr;   // 当前元素的编码起点
+        const uint8_t* next_ = nullptr;  // 下一个元素的编码起点
+        const uint8_t* end_ = nullptr;
+        uint32_t index_ = 0;
+        uint32_t value_ = 0;
+    };
+
+    NeighborRange() = default;
+
+    NeighborRange(const uint8_t* data, size_t size, NeighborCodec codec)
+        : codec_(codec), data_(data), end_(data + size) {
+        if (codec_ == NeighborCodec::kStreamVByte && data_ < end_) {
+            count_ = DecodeVarint(data_);
+            control_ = data_;
+            data_ += (count_ + 3) / 4;
+        }
+    }
+
+    Iterator begin() const { return Iterator(codec_, control_, data_, end_); }
+
+    Iterator end() const { return Iterator(codec_, control_, end_, end_); }
+
+    bool empty() const { return data_ == end_; }
+
+    // 邻居数；StreamVByte 直接读表头，varint 需扫描一遍字节
+    size_t size() const {
+        if (codec_ == NeighborCodec::kStreamVByte)
+            return count_;
+        size_t n = 0;
+        for (const uint8_t* p = data_; p < end_; ++p) {
+            n += (*p & 0x80) == 0;
+        }
+        return n;
+    }
+
+    // 对每个邻居调用 fn(neighbor_id)
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        if (codec_ == NeighborCodec::kVarint) {
+            const uint8_t* ptr = data_;
+            uint32_t prev = 0;
+            while (ptr < end_) {
+                prev += DecodeVarint(ptr);
+                fn(prev);
+            }
+            return;
+        }
+
+        // 按块批量 SIMD 解码
+        constexpr uint32_t kBlock = 64;
+        uint32_t block[kBlock];
+        const uint8_t* control = control_;
+        const uint8_t* ptr = data_;
+        uint32_t prev = 0;
+        for (uint32_t done = 0; done < count_; done += kBlock) {
+            uint32_t n = count_ - done < kBlock ? count_ - done : kBlock;
+            ptr = DecodeStreamVByte(control, ptr, end_, n, prev, block);
+            for (uint32_t i = 0; i < n; ++i) {
+                fn(block[i]);
+            }
+            control += kBlock / 4;
+            prev = block[n - 1];
+        }
+    }
+
+    // 只对下标在 [first, last) 的邻居调用 fn。
+    // delta 编码需要前缀和，first 之前的部分仍要解码但不回调；
+    // 有分段时应按段的恢复点定位（见 forEachAllowed）。
+    template <typename Fn>
+    void ForEachInRange(size_t first, size_t last, Fn&& fn) const {
+        if (codec_ == NeighborCodec::kVarint) {
+            const uint8_t* ptr = data_;
+            uint32_t prev = 0;
+            for (size_t i = 0; ptr < end_ && i < last; ++i) {
+                prev += DecodeVarint(ptr);
+                if (i >= first)
+                    fn(prev);
+            }
+            return;
+        }
+
+        constexpr uint32_t kBlock = 64;
+        uint32_t block[kBlock];
+        const uint8_t* control = control_;
+        const uint8_t* ptr = data_;
+        uint32_t prev = 0;
+        last = last < count_ ? last : count_;
+        for (size_t done = 0; done < last; done += kBlock) {
+            uint32_t n = count_ - done < kBlock ? count_ - done : kBlock;
+            ptr = DecodeStreamVByte(control, ptr, end_, n, prev, block);
+            size_t from = first > done ? first - done : 0;
+            size_t to = last - done < n ? last - done : n;
+            for (size_t i = from; i < to; ++i) {
+                fn(block[i]);
+            }
+            control += kBlock / 4;
+            prev = block[n - 1];
+        }
+    }
+
+    // 对段内下标在 [from, to) 的邻居调用 fn，fn 返回 false 时提前结束。
+    // 返回是否遍历完整个区间。
+    template <typename Fn>
+    bool ForEachInSegment(const LabelSegment& segment, size_t from, size_t to,
+                          Fn&& fn) const {
+        size_t total = segment.skip + to;
+        from += segment.skip;
+        uint32_t prev = segment.base;
+        const uint8_t* ptr = data_ + segment.byte_offset;
+        if (codec_ == NeighborCodec::kVarint) {
+            for (size_t i = 0; i < total; ++i) {
+                prev += DecodeVarint(ptr);
+                if (i >= from && !fn(prev))
+                    return false;
+            }
+            return true;
+        }
+
+        constexpr uint32_t kBlock = 64;
+        uint32_t block[kBlock];
+        const uint8_t* control = control_ + segment.resume / 4;
+        for (size_t done = 0; done < total; done += kBlock) {
+            uint32_t n = total - done < kBlock ? total - done : kBlock;
+            ptr = DecodeStreamVByte(control, ptr, end_, n, prev, block);
+            for (size_t i = from > done ? from - done : 0; i < n; ++i) {
+                if (!fn(block[i]))
+                    return false;
+            }
+            control += kBlock / 4;
+            prev = block[n - 1];
+        }
+        return true;
+    }
+
+    // 解码到调用方提供的缓冲区（先清空，复用其容量），返回邻居数
+    size_t DecodeInto(std::vector<uint32_t>& out) const {
+        out.clear();
+        if (codec_ == NeighborCodec::kVarint) {
+            ForEach([&out](uint32_t v) { out.push_back(v); });
+        } else if (count_ > 0) {
+            out.resize(count_);
+            DecodeStreamVByte(control_, data_, end_, count_, 0, out.data());
+        }
+        return out.size();
+    }
+
+   private:
+    NeighborCodec codec_ = NeighborCodec::kVarint;
+    const uint8_t* control_ = nullptr;
+    const uint8_t* data_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    uint32_t count_ = 0;
+};
+
+}  // namespace hackathon
@@ -0,0 +1,267 @@
+// src/storage/node_interner.cc
+#include "node_interner.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace hackathon {
+
+namespace {
+
+constexpr size_t kHeaderBytes = 10;
+constexpr size_t kChunkBytes = size_t(1) << 20;
+constexpr size_t kInitialSlots = 1024;
+
+struct EntryView {
+    uint32_t id;
+    uint16_t label;
+    std::string_view str;
+};
+
+EntryView readEntry(const char* entry) {
+    EntryView view;
+    uint32_t len;
+    std::memcpy(&view.id, entry, 4);
+    std::memcpy(&view.label, entry + 4, 2);
+    std::memcpy(&len, entry + 6, 4);
+    view.str = std::string_view(entry + kHeaderBytes, len);
+    return view;
+}
+
+// 遍历一段首尾相接的条目
+template <typename Fn>
+void forEachEntry(const char* data, size_t size, Fn&& fn) {
+    size_t pos = 0;
+    while (pos + kHeaderBytes <= size) {
+        EntryView view = readEntry(data + pos);
+        if (pos + kHeaderBytes + view.str.size() > size)
+            throw std::runtime_error("Corrupt node spill file");
+        fn(data + pos, view);
+        pos += kHeaderBytes + view.str.size();
+    }
+}
+
+std::unique_ptr<char[]> readFile(const std::string& path, size_t& size) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        throw std::runtime_error("Failed to open node spill file: " + path);
+    size = std::filesystem::file_size(path);
+    std::unique_ptr<char[]> data(new char[std::max<size_t>(size, 1)]);
+    bool ok = fread(data.get(), 1, size, file) == size;
+    fclose(file);
+    if (!ok)
+        throw std::runtime_error("Failed to read node spill file: " + path);
+    return data;
+}
+
+}  // namespace
+
+NodeInterner::NodeInterner(const std::string& spill_prefix,
+                           size_t memory_budget, unsigned partitions)
+    : spill_prefix_(spill_prefix),
+      memory_budget_(memory_budget),
+      partitions_(std::max(1u, partitions)),
+      parts_(new Partition[std::max(1u, partitions)]) {}
+
+NodeInterner::~NodeInterner() {
+    for (unsigned p = 0; p < partitions_; ++p) {
+        std::error_code ec;
+        std::filesystem::remove(SpillPath(p), ec);
+    }
+}
+
+uint64_t NodeInterner::Hash(std::string_view str) const {
+    return std::hash<std::string_view>{}(str);
+}
+
+unsigned NodeInterner::PartitionOf(std::string_view str) const {
+    // 高位选分区，低位选槽位
+    return (Hash(str) >> 40) % partitions_;
+}
+
+std::string NodeInterner::SpillPath(unsigned partition) const {
+    return spill_prefix_ + "_" + std::to_string(partition) + ".bin";
+}
+
+void NodeInterner::AddBytes(Partition& part, size_t bytes) {
+    part.bytes += bytes;
+    total_bytes_ += bytes;
+}
+
+uint32_t NodeInterner::Intern(std::string_view str, uint16_t label) {
+    uint64_t hash = Hash(str);
+    Partition& part = parts_[(hash >> 40) % partitions_];
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(part.mutex);
+        if (part.spilled)
+            return kPending;
+        if (part.slots.empty())
+            Grow(part);
+
+        size_t mask = part.slots.size() - 1;
+        for (size_t i = hash & mask; part.slots[i].entry; i = (i + 1) & mask) {
+            if (part.slots[i].hash != hash)
+                continue;
+            EntryView view = readEntry(part.slots[i].entry);
+            if (view.str != str)
+                continue;
+            if (view.label != label)
+                throw std::runtime_error("Conflicting labels for node " +
+                                         std::string(str));
+            return view.id;
+        }
+
+        id = next_id_++;
+        if (id == kPending)
+            throw std::runtime_error("Too many distinct node ids");
+        if ((part.entries + 1) * 2 > part.slots.size())
+            Grow(part);
+        Insert(part, Append(part, str, id, label), hash);
+    }
+    if (total_bytes_.load(std::memory_order_relaxed) > memory_budget_ &&
+        auto_spill_.load(std::memory_order_relaxed))
+        MaybeSpill();
+    return id;
+}
+
+const char* NodeInterner::Append(Partition& part, std::string_view str,
+                                 uint32_t id, uint16_t label) {
+    size_t need = kHeaderBytes + str.size();
+    if (part.chunks.empty() ||
+        part.chunks.back().size - part.chunks.back().used < need) {
+        size_t size = std::max(kChunkBytes, need);
+        part.chunks.push_back({std::unique_ptr<char[]>(new char[size]), 0,
+                               size});
+        AddBytes(part, size);
+    }
+    Chunk& chunk = part.chunks.back();
+    char* entry = chunk.data.get() + chunk.used;
+    uint32_t len = str.size();
+    std::memcpy(entry, &id, 4);
+    std::memcpy(entry + 4, &label, 2);
+    std::memcpy(entry + 6, &len, 4);
+    std::memcpy(entry + kHeaderBytes, str.data(), str.size());
+    chunk.used += need;
+    return entry;
+}
+
+void NodeInterner::Insert(Partition& part, const char* entry, uint64_t hash) {
+    size_t mask = part.slots.size() - 1;
+    size_t i = hash & mask;
+    while (part.slots[i].entry) {
+        i = (i + 1) & mask;
+    }
+    part.slots[i] = {entry, hash};
+    part.entries++;
+}
+
+void NodeInterner::Grow(Partition& part) {
+    std::vector<Slot> old = std::move(part.slots);
+    size_t size = old.empty() ? kInitialSlots : old.size() * 2;
+    part.slots.assign(size, Slot{nullptr, 0});
+    part.entries = 0;
+    for (const Slot& slot : old) {
+        if (slot.entry)
+            Insert(part, slot.entry, slot.hash);
+    }
+    AddBytes(part, (size - old.size()) * sizeof(Slot));
+}
+
+// 一次只有一个线程溢写，其他超出预算的线程直接返回
+void NodeInterner::MaybeSpill() {
+    std::unique_lock<std::mutex> spill_lock(spill_mutex_, std::try_to_lock);
+    if (!spill_lock.owns_lock())
+        return;
+    while (total_bytes_.load() > memory_budget_) {
+        unsigned victim = partitions_;
+        size_t largest = 0;
+        for (unsigned p = 0; p < partitions_; ++p) {
+            std::lock_guard<std::mutex> lock(parts_[p].mutex);
+            if (!parts_[p].spilled && parts_[p].bytes > largest) {
+                largest = parts_[p].bytes;
+                victim = p;
+            }
+        }
+        if (victim == partitions_)
+            return;
+        std::lock_guard<std::mutex> lock(parts_[victim].mutex);
+        SpillLocked(parts_[victim], victim);
+    }
+}
+
+void NodeInterner::Spill(unsigned partition) {
+    std::lock_guard<std::mutex> lock(parts_[partition].mutex);
+    SpillLocked(parts_[partition], partition);
+}
+
+void NodeInterner::SpillLocked(Partition& part, unsigned partition) {
+    std::string path = SpillPath(partition);
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        throw std::runtime_error("Failed to create node spill file: " + path);
+    for (const Chunk& chunk : part.chunks) {
+        if (fwrite(chunk.data.get(), 1, chunk.used, file) != chunk.used) {
+            fclose(file);
+            throw std::runtime_error("Failed to write node spill file: " +
+                                     path);
+        }
+    }
+    fclose(file);
+
+    total_bytes_ -= part.bytes;
+    part.bytes = 0;
+    part.chunks.clear();
+    std::vector<Slot>().swap(part.slots);
+    part.entries = 0;
+    part.spilled = true;
+}
+
+void NodeInterner::Reload(unsigned partition) {
+    Partition& part = parts_[partition];
+    std::lock_guard<std::mutex> lock(part.mutex);
+    if (!part.spilled)
+        return;
+    size_t size;
+    std::unique_ptr<char[]> data = readFile(SpillPath(partition), size);
+    size_t count = 0;
+    forEachEntry(data.get(), size,
+                 [&](const char*, const EntryView&) { count++; });
+
+    size_t slots = kInitialSlots;
+    while (slots < count * 2) {
+        slots *= 2;
+    }
+    part.slots.assign(slots, Slot{nullptr, 0});
+    forEachEntry(data.get(), size,
+                 [&](const char* entry, const EntryView& view) {
+                     Insert(part, entry, Hash(view.str));
+                 });
+    // 载入的整块之后不再追加，新条目另起一块
+    part.chunks.push_back({std::move(data), size, size});
+    AddBytes(part, size + slots * sizeof(Slot));
+    part.spilled = false;
+}
+
+void NodeInterner::ForEach(
+    const std::function<void(uint32_t, std::string_view, uint16_t)>& fn)
+    const {
+    auto call = [&](const char*, const EntryView& view) {
+        fn(view.id, view.str, view.label);
+    };
+    for (unsigned p = 0; p < partitions_; ++p) {
+        const Partition& part = parts_[p];
+        if (part.spilled) {
+            size_t size;
+            std::unique_ptr<char[]> data = readFile(SpillPath(p), size);
+            forEachEntry(data.get(), size, call);
+        } else {
+            for (const Chunk& chunk : part.chunks) {
+                forEachEntry(chunk.data.get(), chunk.used, call);
+            }
+        }
+    }
+}
+
+}  // namespace hackathon
@@ -0,0 +1,101 @@
+// src/storage/node_interner.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hackathon {
+
+// 单遍构建时为节点字符串分配稠密 ID（按首次 Intern 的顺序）。
+// 字符串按哈希分到若干分区，每个分区一把锁：字符串连同 ID 和顶点标签
+// 追加到分区的 arena（按大块分配，不逐串分配），开放寻址表只存
+// 条目指针和哈希。所有分区合计超出内存预算时，把最大的分区整体
+// 溢写到磁盘并释放，之后落在该分区的字符串返回 kPending，
+// 由调用方暂存，在 Reload 该分区后再解析。
+// ID 只保证稠密，不保证两次构建相同：并发 Intern 时谁先分配取决于线程调度，
+// 溢写分区中的新字符串要等 Reload 后按调用方暂存的顺序（同样来自并发追加）
+// 分配，排在溢写前已分配的 ID 之后。对外只应使用字符串 ID。
+class NodeInterner {
+   public:
+    static constexpr uint32_t kPending = static_cast<uint32_t>(-1);
+
+    NodeInterner(const std::string& spill_prefix, size_t memory_budget,
+                 unsigned partitions = 64);
+    ~NodeInterner();
+
+    NodeInterner(const NodeInterner&) = delete;
+    NodeInterner& operator=(const NodeInterner&) = delete;
+
+    // 线程安全。已存在时返回原 ID，label 与已记录的不同时抛出异常
+    // （顶点标签须一致，否则保留哪个取决于线程调度）；
+    // 所在分区已溢写时返回 kPending
+    uint32_t Intern(std::string_view str, uint16_t label);
+
+    unsigned Partitions() const { return partitions_; }
+    unsigned PartitionOf(std::string_view str) const;
+
+    // 关闭后超出预算也不再溢写，供 Reload 之后逐分区解析时使用
+    void SetAutoSpill(bool enabled) { auto_spill_ = enabled; }
+
+    // 以下在没有并发 Intern 时调用。
+    // Reload 把已溢写的分区读回内存，Spill 把分区写出并释放内存
+    void Reload(unsigned partition);
+    void Spill(unsigned partition);
+
+    uint32_t Size() const { return next_id_.load(); }
+
+    // 逐个回调所有字符串，顺序不定；已溢写的分区从磁盘读出
+    void ForEach(const std::function<void(uint32_t id, std::string_view str,
+                                          uint16_t label)>& fn) const;
+
+   private:
+    struct Slot {
+        const char* entry;  // nullptr 表示空槽
+        uint64_t hash;
+    };
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t used;
+        size_t size;
+    };
+
+    // 条目格式 [uint32 id][uint16 label][uint32 len][bytes]，
+    // 溢写文件即各块已用部分首尾相接
+    struct Partition {
+        std::mutex mutex;
+        std::vector<Chunk> chunks;
+        std::vector<Slot> slots;
+        size_t entries = 0;
+        size_t bytes = 0;  // arena + 表
+        bool spilled = false;
+    };
+
+    uint64_t Hash(std::string_view str) const;
+    std::string SpillPath(unsigned partition) const;
+    const char* Append(Partition& part, std::string_view str, uint32_t id,
+                       uint16_t label);
+    void Insert(Partition& part, const char* entry, uint64_t hash);
+    void Grow(Partition& part);
+    void AddBytes(Partition& part, size_t bytes);
+    void SpillLocked(Partition& part, unsigned partition);
+    void MaybeSpill();
+
+    std::string spill_prefix_;
+    size_t memory_budget_;
+    unsigned partitions_;
+    std::unique_ptr<Partition[]> parts_;
+    std::atomic<uint32_t> next_id_{0};
+    std::atomic<size_t> total_bytes_{0};
+    std::atomic<bool> auto_spill_{true};
+    std::mutex spill_mutex_;
+};
+
+}  // namespace hackathon
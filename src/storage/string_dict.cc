@@ -0,0 +1,369 @@
+// src/storage/string_dict.cc
+#include "string_dict.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace hackathon {
+
+namespace {
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t levels;
+    uint64_t fallback_count;
+    uint64_t total_bits;
+};
+
+constexpr char kIndexMagic[4] = {'H', 'K', 'M', 'P'};
+constexpr uint32_t kIndexVersion = 1;
+// 每层位图大小为剩余键数的 gamma 倍，越大冲突越少、层数越少
+constexpr double kGamma = 2.0;
+constexpr uint32_t kMaxLevels = 32;
+constexpr uint64_t kRankBlockBits = 512;
+
+uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// 落盘的哈希，不能依赖 std::hash 的实现
+uint64_t hashString(std::string_view str) {
+    constexpr uint64_t c1 = 0x87c37b91114253d5ULL;
+    constexpr uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ str.size();
+    size_t i = 0;
+    auto mix = [&](uint64_t k) {
+        k *= c1;
+        k = std::rotl(k, 31);
+        k *= c2;
+        h ^= k;
+        h = std::rotl(h, 27) * 5 + 0x52dce729;
+    };
+    for (; i + 8 <= str.size(); i += 8) {
+        uint64_t k;
+        std::memcpy(&k, str.data() + i, 8);
+        mix(k);
+    }
+    if (i < str.size()) {
+        uint64_t k = 0;
+        std::memcpy(&k, str.data() + i, str.size() - i);
+        mix(k);
+    }
+    return fmix64(h);
+}
+
+// 第 level 层中的位置，[0, bits)
+uint64_t levelPosition(uint64_t hash, uint32_t level, uint64_t bits) {
+    uint64_t h = fmix64(hash + (level + 1) * 0x9E3779B97F4A7C15ULL);
+    return static_cast<uint64_t>((static_cast<__uint128_t>(h) * bits) >> 64);
+}
+
+bool testBit(const uint64_t* bits, uint64_t pos) {
+    return (bits[pos / 64] >> (pos % 64)) & 1;
+}
+
+constexpr uint64_t kNoBit = static_cast<uint64_t>(-1);
+
+// 逐层检查，返回第一个置位的全局位置，都未置位时返回 kNoBit
+uint64_t findBit(uint64_t hash, uint32_t levels, const uint64_t* level_offsets,
+                 const uint64_t* bits) {
+    for (uint32_t level = 0; level < levels; ++level) {
+        uint64_t level_bits = level_offsets[level + 1] - level_offsets[level];
+        uint64_t pos =
+            level_offsets[level] + levelPosition(hash, level, level_bits);
+        if (testBit(bits, pos))
+            return pos;
+    }
+    return kNoBit;
+}
+
+// pos 之前的置位数：块前缀 + 块内整字 + 本字低位
+uint64_t rankOf(const uint64_t* bits, const uint64_t* ranks, uint64_t pos) {
+    uint64_t word = pos / 64;
+    uint64_t rank = ranks[pos / kRankBlockBits];
+    for (uint64_t w = word / 8 * 8; w < word; ++w) {
+        rank += std::popcount(bits[w]);
+    }
+    uint64_t below = (uint64_t(1) << (pos % 64)) - 1;
+    return rank + std::popcount(bits[word] & below);
+}
+
+// 把 [0, n) 均分给 threads 个线程
+template <typename Fn>
+void parallelFor(size_t n, unsigned threads, Fn&& fn) {
+    threads = std::max(1u, std::min<unsigned>(threads, n / 65536 + 1));
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            fn(t, n * t / threads, n * (t + 1) / threads);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+template <typename T>
+void writeArray(std::ofstream& out, const std::vector<T>& values) {
+    out.write(reinterpret_cast<const char*>(values.data()),
+              values.size() * sizeof(T));
+}
+
+}  // namespace
+
+StringDictionaryBuilder::StringDictionaryBuilder(
+    const std::string& strings_path, const std::string& offsets_path)
+    : strings_(strings_path, std::ios::binary),
+      offsets_path_(offsets_path),
+      offsets_{0} {
+    if (!strings_)
+        throw std::runtime_error("Failed to open file: " + strings_path);
+}
+
+StringDictionaryBuilder::StringDictionaryBuilder(
+    const std::string& strings_path, const std::string& offsets_path,
+    const std::vector<uint32_t>& lengths)
+    : offsets_path_(offsets_path), offsets_{0}, hashes_(lengths.size()) {
+    if (lengths.size() >= StringDictionary::kNotFound)
+        throw std::runtime_error("Too many distinct node ids");
+    offsets_.reserve(lengths.size() + 1);
+    for (uint32_t len : lengths) {
+        offsets_.push_back(offsets_.back() + len);
+    }
+    mapped_size_ = offsets_.back();
+
+    int fd = open(strings_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        throw std::runtime_error("Failed to open file: " + strings_path);
+    if (ftruncate(fd, mapped_size_) == -1) {
+        close(fd);
+        throw std::runtime_error("Failed to resize file: " + strings_path);
+    }
+    if (mapped_size_ > 0) {
+        void* data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Failed to mmap file: " + strings_path);
+        }
+        mapped_ = static_cast<char*>(data);
+    }
+    close(fd);
+}
+
+StringDictionaryBuilder::~StringDictionaryBuilder() {
+    Unmap();
+}
+
+void StringDictionaryBuilder::Unmap() {
+    if (mapped_)
+        munmap(mapped_, mapped_size_);
+    mapped_ = nullptr;
+}
+
+void StringDictionaryBuilder::Set(uint32_t id, std::string_view str) {
+    if (offsets_[id] + str.size() != offsets_[id + 1])
+        throw std::runtime_error("String length mismatch in dictionary");
+    std::memcpy(mapped_ + offsets_[id], str.data(), str.size());
+    hashes_[id] = hashString(str);
+}
+
+void StringDictionaryBuilder::Add(std::string_view str) {
+    if (hashes_.size() >= StringDictionary::kNotFound)
+        throw std::runtime_error("Too many distinct node ids");
+    strings_.write(str.data(), str.size());
+    offsets_.push_back(offsets_.back() + str.size());
+    hashes_.push_back(hashString(str));
+}
+
+// 逐层构建：每个键在本层的位图中取一个位置，独占该位置的键落在这一层，
+// 与其他键冲突的位置清零，冲突的键进入下一层。查找时逐层检查，
+// 第一个置位的位置即为键所在的层，其全局 rank 就是槽位。
+// kMaxLevels 层之后仍冲突的键（实际上只有 64 位哈希完全相同的键）
+// 存入按哈希排序的后备表。
+void StringDictionaryBuilder::Finish(const std::string& index_path,
+                                     unsigned threads) {
+    if (strings_.is_open())
+        strings_.close();
+    Unmap();
+    {
+        std::ofstream out(offsets_path_, std::ios::binary);
+        writeArray(out, offsets_);
+    }
+    std::vector<uint64_t>().swap(offsets_);
+
+    uint32_t count = hashes_.size();
+    std::vector<uint32_t> remaining(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        remaining[i] = i;
+    }
+
+    std::vector<uint64_t> level_offsets{0};
+    std::vector<uint64_t> bits;
+    while (!remaining.empty() && level_offsets.size() <= kMaxLevels) {
+        uint32_t level = level_offsets.size() - 1;
+        uint64_t level_bits =
+            std::max<uint64_t>(64, remaining.size() * kGamma);
+        level_bits = (level_bits + 63) / 64 * 64;
+        std::vector<uint64_t> seen(level_bits / 64, 0);
+        std::vector<uint64_t> collided(level_bits / 64, 0);
+        parallelFor(remaining.size(), threads,
+                    [&](unsigned, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                uint64_t pos =
+                    levelPosition(hashes_[remaining[i]], level, level_bits);
+                uint64_t mask = uint64_t(1) << (pos % 64);
+                uint64_t prev = std::atomic_ref<uint64_t>(seen[pos / 64])
+                                    .fetch_or(mask, std::memory_order_relaxed);
+                if (prev & mask) {
+                    std::atomic_ref<uint64_t>(collided[pos / 64])
+                        .fetch_or(mask, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        std::vector<uint32_t> next;
+        for (uint32_t id : remaining) {
+            uint64_t pos = levelPosition(hashes_[id], level, level_bits);
+            if (testBit(collided.data(), pos))
+                next.push_back(id);
+        }
+        for (size_t w = 0; w < seen.size(); ++w) {
+            bits.push_back(seen[w] & ~collided[w]);
+        }
+        level_offsets.push_back(level_offsets.back() + level_bits);
+        remaining = std::move(next);
+    }
+
+    std::vector<uint64_t> ranks((bits.size() * 64 + kRankBlockBits - 1) /
+                                kRankBlockBits);
+    uint64_t placed = 0;
+    for (size_t w = 0; w < bits.size(); ++w) {
+        if (w % (kRankBlockBits / 64) == 0)
+            ranks[w / (kRankBlockBits / 64)] = placed;
+        placed += std::popcount(bits[w]);
+    }
+
+    std::vector<uint64_t> fallback;
+    std::sort(remaining.begin(), remaining.end(), [&](uint32_t a, uint32_t b) {
+        return hashes_[a] < hashes_[b];
+    });
+    for (uint32_t id : remaining) {
+        fallback.push_back(hashes_[id]);
+        fallback.push_back(id);
+    }
+
+    IndexHeader header{};
+    std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kIndexVersion;
+    header.count = count;
+    header.levels = level_offsets.size() - 1;
+    header.fallback_count = remaining.size();
+    header.total_bits = level_offsets.back();
+
+    // 按查找的过程计算每个键的槽位，生成槽位 → ID 表
+    std::vector<uint32_t> slot_to_id(placed);
+    parallelFor(count, threads, [&](unsigned, size_t begin, size_t end) {
+        for (size_t id = begin; id < end; ++id) {
+            uint64_t pos = findBit(hashes_[id], header.levels,
+                                   level_offsets.data(), bits.data());
+            if (pos != kNoBit)
+                slot_to_id[rankOf(bits.data(), ranks.data(), pos)] = id;
+        }
+    });
+    std::vector<uint64_t>().swap(hashes_);
+
+    std::ofstream out(index_path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeArray(out, level_offsets);
+    writeArray(out, bits);
+    writeArray(out, ranks);
+    writeArray(out, fallback);
+    writeArray(out, slot_to_id);
+    if (!out)
+        throw std::runtime_error("Failed to write file: " + index_path);
+}
+
+StringDictionary::StringDictionary(const uint8_t* strings, size_t strings_size,
+                                   const uint8_t* offsets, size_t offsets_size,
+                                   const uint8_t* index, size_t index_size) {
+    IndexHeader header;
+    if (index_size < sizeof(header))
+        throw std::runtime_error("Corrupt string dictionary index");
+    std::memcpy(&header, index, sizeof(header));
+    if (std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 ||
+        header.version != kIndexVersion)
+        throw std::runtime_error("Unsupported string dictionary index");
+
+    uint64_t words = header.total_bits / 64;
+    uint64_t rank_count = (header.total_bits + kRankBlockBits - 1) /
+                          kRankBlockBits;
+    uint64_t placed = header.count - header.fallback_count;
+    uint64_t expected = sizeof(header) +
+                        8 * (header.levels + 1 + words + rank_count +
+                             2 * header.fallback_count) +
+                        4 * placed;
+    if (header.fallback_count > header.count || header.total_bits % 64 ||
+        index_size != expected ||
+        offsets_size != 8 * (uint64_t(header.count) + 1))
+        throw std::runtime_error("Corrupt string dictionary index");
+
+    strings_ = reinterpret_cast<const char*>(strings);
+    offsets_ = reinterpret_cast<const uint64_t*>(offsets);
+    if (offsets_[header.count] != strings_size)
+        throw std::runtime_error("Corrupt string dictionary");
+
+    count_ = header.count;
+    levels_ = header.levels;
+    level_offsets_ = reinterpret_cast<const uint64_t*>(index + sizeof(header));
+    bits_ = level_offsets_ + levels_ + 1;
+    ranks_ = bits_ + words;
+    fallback_ = ranks_ + rank_count;
+    fallback_count_ = header.fallback_count;
+    slot_to_id_ =
+        reinterpret_cast<const uint32_t*>(fallback_ + 2 * fallback_count_);
+}
+
+uint32_t StringDictionary::Find(std::string_view str) const {
+    if (count_ == 0)
+        return kNotFound;
+    uint64_t hash = hashString(str);
+    uint64_t pos = findBit(hash, levels_, level_offsets_, bits_);
+    if (pos != kNoBit) {
+        // 键落在哪一层是确定的，命中的槽位原串不同即说明不存在
+        uint32_t id = slot_to_id_[rankOf(bits_, ranks_, pos)];
+        return Get(id) == str ? id : kNotFound;
+    }
+
+    const uint64_t* begin = fallback_;
+    size_t lo = 0;
+    size_t hi = fallback_count_;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (begin[2 * mid] < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (; lo < fallback_count_ && begin[2 * lo] == hash; ++lo) {
+        uint32_t id = static_cast<uint32_t>(begin[2 * lo + 1]);
+        if (Get(id) == str)
+            return id;
+    }
+    return kNotFound;
+}
+
+}  // namespace hackathon
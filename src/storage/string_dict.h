@@ -0,0 +1,93 @@
+// src/storage/string_dict.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hackathon {
+
+// 字符串 → ID 字典的磁盘格式，三个文件都整体 mmap，加载时不做任何解析：
+//   strings：所有字符串按 ID 顺序首尾相接
+//   offsets：uint64 × (count + 1)，第 i 个字符串为 [offsets[i], offsets[i+1])
+//   index：最小完美哈希（BBHash 式多层位图 + rank），把每个字符串映射到
+//          [0, count) 中唯一的槽位，槽位再查表得到 ID
+// 查找时字符串只哈希一次，各层位置由这个 64 位哈希派生，
+// 命中后与 strings 中的原串比较一次即可确认。
+class StringDictionaryBuilder {
+   public:
+    // 写入 strings_path / offsets_path，index 在 Finish 时生成
+    StringDictionaryBuilder(const std::string& strings_path,
+                            const std::string& offsets_path);
+
+    // 乱序写入：lengths[i] 为 ID i 的字符串长度，之后对每个 ID 调用一次 Set。
+    // strings 文件预先按总长度建好并映射，Set 直接拷贝到对应位置
+    StringDictionaryBuilder(const std::string& strings_path,
+                            const std::string& offsets_path,
+                            const std::vector<uint32_t>& lengths);
+    ~StringDictionaryBuilder();
+
+    StringDictionaryBuilder(const StringDictionaryBuilder&) = delete;
+    StringDictionaryBuilder& operator=(const StringDictionaryBuilder&) = delete;
+
+    // ID 为调用次序，字符串不得重复
+    void Add(std::string_view str);
+
+    void Set(uint32_t id, std::string_view str);
+
+    uint32_t Size() const { return static_cast<uint32_t>(hashes_.size()); }
+
+    // 构建完美哈希并写出 index_path，threads 为构建用的线程数
+    void Finish(const std::string& index_path, unsigned threads);
+
+   private:
+    void Unmap();
+
+    std::ofstream strings_;
+    char* mapped_ = nullptr;  // 乱序写入时映射的 strings 文件
+    size_t mapped_size_ = 0;
+    std::string offsets_path_;
+    std::vector<uint64_t> offsets_;
+    std::vector<uint64_t> hashes_;
+};
+
+// mmap 数据上的只读视图，不拥有内存
+class StringDictionary {
+   public:
+    static constexpr uint32_t kNotFound = static_cast<uint32_t>(-1);
+
+    StringDictionary() = default;
+
+    // 校验三段数据的大小是否一致，不一致时抛出异常
+    StringDictionary(const uint8_t* strings, size_t strings_size,
+                     const uint8_t* offsets, size_t offsets_size,
+                     const uint8_t* index, size_t index_size);
+
+    uint32_t Size() const { return count_; }
+
+    // 不存在时返回 kNotFound
+    uint32_t Find(std::string_view str) const;
+
+    // 指向映射数据，字典所在的 GraphStorage 析构或重建后失效
+    std::string_view Get(uint32_t id) const {
+        return std::string_view(strings_ + offsets_[id],
+                                offsets_[id + 1] - offsets_[id]);
+    }
+
+   private:
+    const char* strings_ = nullptr;
+    const uint64_t* offsets_ = nullptr;
+    uint32_t count_ = 0;
+    uint32_t levels_ = 0;
+    const uint64_t* level_offsets_ = nullptr;  // 各层起始位，levels_ + 1 个
+    const uint64_t* bits_ = nullptr;
+    const uint64_t* ranks_ = nullptr;  // 每 512 位之前的置位数
+    const uint32_t* slot_to_id_ = nullptr;
+    const uint64_t* fallback_ = nullptr;  // 末层仍冲突的 (哈希, ID)，按哈希排序
+    uint64_t fallback_count_ = 0;
+};
+
+}  // namespace hackathon
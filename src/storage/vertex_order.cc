@@ -0,0 +1,233 @@
+// src/storage/vertex_order.cc
+#include "vertex_order.h"
+#include <algorithm>
+#include <numeric>
+#include "graph_storage.h"
+
+namespace hackathon {
+
+namespace {
+
+// Gorder 中通过共同入邻居累加兄弟关系时跳过出度超过此值的顶点，
+// 否则一个 hub 进出窗口就要更新它的全部邻居对
+constexpr uint32_t kGorderHubDegree = 256;
+
+uint32_t segmentDegree(std::span<const LabelSegment> segments) {
+    uint32_t degree = 0;
+    for (const auto& segment : segments) {
+        degree += segment.count;
+    }
+    return degree;
+}
+
+// 键值只会 ±1 的最大堆：按键分桶的双向链表，取最大时指针向下找非空桶
+class UnitHeap {
+   public:
+    static constexpr uint32_t kNil = static_cast<uint32_t>(-1);
+
+    explicit UnitHeap(uint32_t n)
+        : key_(n, 0), prev_(n, kNil), next_(n, kNil), in_heap_(n, 1),
+          head_(1, kNil) {
+        for (uint32_t v = n; v-- > 0;) {
+            Link(v);
+        }
+    }
+
+    bool Contains(uint32_t v) const { return in_heap_[v]; }
+
+    void Increment(uint32_t v) {
+        Unlink(v);
+        key_[v]++;
+        if (key_[v] >= head_.size())
+            head_.push_back(kNil);
+        top_ = std::max(top_, key_[v]);
+        Link(v);
+    }
+
+    void Decrement(uint32_t v) {
+        Unlink(v);
+        key_[v]--;
+        Link(v);
+    }
+
+    void Remove(uint32_t v) {
+        Unlink(v);
+        in_heap_[v] = 0;
+    }
+
+    uint32_t PopMax() {
+        while (head_[top_] == kNil) {
+            top_--;
+        }
+        uint32_t v = head_[top_];
+        Remove(v);
+        return v;
+    }
+
+   private:
+    void Link(uint32_t v) {
+        uint32_t& head = head_[key_[v]];
+        prev_[v] = kNil;
+        next_[v] = head;
+        if (head != kNil)
+            prev_[head] = v;
+        head = v;
+    }
+
+    void Unlink(uint32_t v) {
+        if (prev_[v] != kNil)
+            next_[prev_[v]] = next_[v];
+        else
+            head_[key_[v]] = next_[v];
+        if (next_[v] != kNil)
+            prev_[next_[v]] = prev_[v];
+    }
+
+    std::vector<uint32_t> key_;
+    std::vector<uint32_t> prev_;
+    std::vector<uint32_t> next_;
+    std::vector<uint8_t> in_heap_;
+    std::vector<uint32_t> head_;
+    uint32_t top_ = 0;
+};
+
+std::vector<uint32_t> degreeOrder(const std::vector<uint32_t>& degree) {
+    std::vector<uint32_t> order(degree.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return degree[a] > degree[b];
+    });
+    return order;
+}
+
+// 从度数最小的未访问顶点开始做无向 BFS，邻居按度数升序入队，最后整体反转
+std::vector<uint32_t> rcmOrder(const GraphStorage& graph,
+                               const std::vector<uint32_t>& degree) {
+    uint32_t n = degree.size();
+    std::vector<uint32_t> starts(n);
+    std::iota(starts.begin(), starts.end(), 0);
+    std::stable_sort(starts.begin(), starts.end(), [&](uint32_t a, uint32_t b) {
+        return degree[a] < degree[b];
+    });
+
+    std::vector<uint8_t> visited(n, 0);
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> neighbors;
+    order.reserve(n);
+    for (uint32_t start : starts) {
+        if (visited[start])
+            continue;
+        visited[start] = 1;
+        order.push_back(start);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            uint32_t v = order[head];
+            neighbors.clear();
+            auto collect = [&](uint32_t u) {
+                if (!visited[u]) {
+                    visited[u] = 1;
+                    neighbors.push_back(u);
+                }
+            };
+            graph.OutNeighbors(v).ForEach(collect);
+            graph.InNeighbors(v).ForEach(collect);
+            std::stable_sort(neighbors.begin(), neighbors.end(),
+                             [&](uint32_t a, uint32_t b) {
+                                 return degree[a] < degree[b];
+                             });
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Gorder（Wei et al., SIGMOD 2016）：依次放置与最近 window 个已放置顶点
+// 关系最紧密的顶点。关系分数 = 直接相连的边数 + 共同入邻居数，
+// 顶点进入窗口时给相关顶点加分，离开窗口时减分，用 UnitHeap 取最大值
+std::vector<uint32_t> gorderOrder(const GraphStorage& graph,
+                                  const std::vector<uint32_t>& out_degree,
+                                  const std::vector<uint32_t>& in_degree,
+                                  unsigned window) {
+    uint32_t n = out_degree.size();
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    if (n == 0)
+        return order;
+
+    UnitHeap heap(n);
+    auto update = [&](uint32_t placed, bool add) {
+        auto touch = [&](uint32_t u) {
+            if (!heap.Contains(u))
+                return;
+            if (add)
+                heap.Increment(u);
+            else
+                heap.Decrement(u);
+        };
+        graph.OutNeighbors(placed).ForEach(touch);
+        bool expand_siblings = in_degree[placed] <= kGorderHubDegree;
+        graph.InNeighbors(placed).ForEach([&](uint32_t parent) {
+            touch(parent);
+            if (!expand_siblings || out_degree[parent] > kGorderHubDegree)
+                return;
+            graph.OutNeighbors(parent).ForEach([&](uint32_t sibling) {
+                if (sibling != placed)
+                    touch(sibling);
+            });
+        });
+    };
+
+    // 从入度最大的顶点开始
+    uint32_t start = std::max_element(in_degree.begin(), in_degree.end()) -
+                     in_degree.begin();
+    heap.Remove(start);
+    order.push_back(start);
+    while (order.size() < n) {
+        update(order.back(), true);
+        if (order.size() > window)
+            update(order[order.size() - 1 - window], false);
+        order.push_back(heap.PopMax());
+    }
+    return order;
+}
+
+}  // namespace
+
+std::vector<uint32_t> ComputeVertexOrder(const GraphStorage& graph,
+                                         VertexOrder order, unsigned window) {
+    uint32_t n = graph.NodeCount();
+    std::vector<uint32_t> out_degree(n);
+    std::vector<uint32_t> in_degree(n);
+    std::vector<uint32_t> degree(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        out_degree[v] = segmentDegree(graph.OutSegments(v));
+        in_degree[v] = segmentDegree(graph.InSegments(v));
+        degree[v] = out_degree[v] + in_degree[v];
+    }
+
+    std::vector<uint32_t> sequence;  // 第 i 个放置的旧 ID
+    switch (order) {
+        case VertexOrder::kNone:
+            sequence.resize(n);
+            std::iota(sequence.begin(), sequence.end(), 0);
+            break;
+        case VertexOrder::kDegree:
+            sequence = degreeOrder(degree);
+            break;
+        case VertexOrder::kRcm:
+            sequence = rcmOrder(graph, degree);
+            break;
+        case VertexOrder::kGorder:
+            sequence = gorderOrder(graph, out_degree, in_degree,
+                                   std::max(1u, window));
+            break;
+    }
+
+    std::vector<uint32_t> perm(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        perm[sequence[i]] = i;
+    }
+    return perm;
+}
+
+}  // namespace hackathon
@@ -0,0 +1,25 @@
+// src/storage/vertex_order.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace hackathon {
+
+class GraphStorage;
+
+// 构建时可选的顶点重编号方式，数值写入格式头，不可修改已有取值
+enum class VertexOrder : uint32_t {
+    kNone = 0,    // 保持分配时的顺序（首次出现）
+    kDegree = 1,  // 按出入度之和降序，hub 集中在低 ID
+    kRcm = 2,     // Reverse Cuthill-McKee：无向 BFS 逐层编号，邻居 ID 相近
+    kGorder = 3,  // Gorder：贪心地让相邻编号的顶点共享邻居
+};
+
+// 根据已建好的 CSR 计算新编号，返回 perm[旧 ID] = 新 ID。
+// window 为 Gorder 的窗口大小，其他方式忽略
+std::vector<uint32_t> ComputeVertexOrder(const GraphStorage& graph,
+                                         VertexOrder order,
+                                         unsigned window = 5);
+
+}  // namespace hackathon
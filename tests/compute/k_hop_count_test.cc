@@ -1,11 +1,358 @@
 #include "k_hop_count.h"
+#include "k_hop_batch.h"
+#include "k_hop_cache.h"
+#include "k_hop_reach.h"
+#include "k_hop_sketch.h"
+#include <cmath>
 #include <iostream>
 
 using namespace std;
 
+static int failures = 0;
+
+static void check(uint64_t got, uint64_t want, const string& what) {
+    if (got != want) {
+        cout << "FAILED: " << what << " got " << got << " want " << want
+             << endl;
+        failures++;
+    }
+}
+
 int main() {
-    k_hop_count kHopCount;
-    kHopCount.kHopCount();
-    cout << "start helloiiiiiiiii" << endl;
-    return 0;
-}
\ No newline at end of file
+    string dir = filesystem::temp_directory_path() / "k_hop_count_test";
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir);
+    {
+        // a -> b -> c -> d，a -> e，e -> b，f 孤立于 a
+        ofstream csv(dir + "/edges.csv");
+        csv << "startId,startLabel,edgeLabel,endId,endLabel\n"
+            << "a,P,knows,b,P\n"
+            << "b,P,knows,c,P\n"
+            << "c,P,knows,d,P\n"
+            << "a,P,knows,e,P\n"
+            << "e,P,knows,b,P\n"
+            << "f,P,knows,a,P\n";
+    }
+    hackathon::GraphStorage graph(dir + "/graph_data");
+    graph.BuildFromCSV(dir + "/edges.csv");
+
+    check(k_hop_count({"a"}, 0, {}).kHopCount(graph), 0, "a k=0");
+    check(k_hop_count({"a"}, 1, {}).kHopCount(graph), 2, "a k=1");
+    check(k_hop_count({"a"}, 2, {}).kHopCount(graph), 3, "a k=2");
+    check(k_hop_count({"a"}, 3, {}).kHopCount(graph), 4, "a k=3");
+    check(k_hop_count({"a"}, 10, {}).kHopCount(graph), 4, "a k=10");
+    check(k_hop_count({"d"}, 3, {}).kHopCount(graph), 0, "sink");
+    check(k_hop_count({"b", "e"}, 1, {}).kHopCount(graph), 1,
+          "multiple sources");
+    check(k_hop_count({"missing"}, 2, {}).kHopCount(graph), 0,
+          "unknown source");
+
+    // 方向优化、并行扩展与串行纯自顶向下结果一致
+    KHopOptions push_only;
+    push_only.direction_optimizing = false;
+    push_only.parallel = false;
+    // 强制每层都走线程池
+    KHopOptions parallel;
+    parallel.parallel_min_work = 1;
+    for (const char* source : {"a", "b", "c", "d", "e", "f"}) {
+        for (int k = 0; k <= 4; ++k) {
+            k_hop_count query({source}, k, {});
+            uint64_t want = query.kHopCount(graph, push_only);
+            check(query.kHopCount(graph), want,
+                  string("direction optimizing from ") + source);
+            check(query.kHopCount(graph, parallel), want,
+                  string("parallel from ") + source);
+        }
+    }
+
+    // 强制 frontier 只用一种表示，结果与自动切换一致；也覆盖缓存的进度继续
+    KHopOptions sparse_only;
+    sparse_only.sparse_ratio = 1;
+    sparse_only.dense_ratio = 0;
+    KHopOptions roaring_only;
+    roaring_only.sparse_ratio = 0;
+    roaring_only.dense_ratio = 0;
+    KHopOptions dense_only;
+    dense_only.sparse_ratio = 0;
+    dense_only.dense_ratio = UINT32_MAX;
+    for (const KHopOptions& forced : {sparse_only, roaring_only, dense_only}) {
+        for (const char* source : {"a", "b", "f"}) {
+            KHopState state;
+            for (int k = 0; k <= 4; ++k) {
+                k_hop_count query({source}, k, {});
+                check(query.kHopCountFrom(graph, state, forced),
+                      query.kHopCount(graph, push_only),
+                      string("forced representation from ") + source);
+            }
+        }
+    }
+
+    // 平铺位图跨越多个缓存行：计数、差集与并集
+    {
+        DenseBitset odd(1000), low(1000);
+        for (uint32_t v = 0; v < 1000; ++v) {
+            if (v % 2)
+                odd.Set(v);
+            if (v < 600)
+                low.Set(v);
+        }
+        check(odd.Count(), 500, "dense bitset count");
+        DenseBitset rest = odd;
+        rest.AndNot(low);
+        check(rest.Count(), 200, "dense bitset and-not");
+        rest.Or(low);
+        check(rest.Count(), 800, "dense bitset or");
+    }
+
+    // 按边标签和终点标签过滤：
+    // x -knows-> y -likes-> z，x -likes-> w(Company)，y -knows-> w
+    {
+        ofstream csv(dir + "/labeled.csv");
+        csv << "startId,startLabel,edgeLabel,endId,endLabel\n"
+            << "x,Person,knows,y,Person\n"
+            << "y,Person,likes,z,Person\n"
+            << "x,Person,likes,w,Company\n"
+            << "y,Person,knows,w,Company\n";
+    }
+    hackathon::GraphStorage labeled(dir + "/labeled_data");
+    labeled.BuildFromCSV(dir + "/labeled.csv");
+
+    check(k_hop_count({"x"}, 2, {"knows"}).kHopCount(labeled), 2,
+          "knows only");
+    check(k_hop_count({"x"}, 2, {"likes"}).kHopCount(labeled), 1,
+          "likes only");
+    check(k_hop_count({"x"}, 2, {"knows", "likes"}).kHopCount(labeled), 3,
+          "both edge labels");
+    check(k_hop_count({"x"}, 2, {"follows"}).kHopCount(labeled), 0,
+          "unknown edge label");
+    k_hop_count companies({"x"}, 2, {});
+    companies.setEndLabel("Company");
+    check(companies.kHopCount(labeled), 1, "end label");
+    companies.setEndLabel("Place");
+    check(companies.kHopCount(labeled), 0, "unknown end label");
+    for (const char* source : {"x", "y"}) {
+        for (int k = 0; k <= 3; ++k) {
+            k_hop_count query({source}, k, {"likes"});
+            uint64_t want = query.kHopCount(labeled, push_only);
+            check(query.kHopCount(labeled), want,
+                  string("labeled direction optimizing from ") + source);
+            check(query.kHopCount(labeled, parallel), want,
+                  string("labeled parallel from ") + source);
+        }
+    }
+
+    // 放开预取门槛，小图上也走预取流水（自顶向下两级、自底向上一级），
+    // 结果与不预取时一致
+    KHopOptions no_prefetch;
+    no_prefetch.prefetch_distance = 0;
+    for (uint32_t prefetch_distance : {1u, 8u}) {
+        KHopOptions prefetched;
+        prefetched.prefetch_distance = prefetch_distance;
+        prefetched.prefetch_sparse_ratio = 0;
+        prefetched.prefetch_min_bitmap_words = 0;
+        KHopOptions prefetched_push = prefetched;
+        prefetched_push.direction_optimizing = false;
+        for (int k = 0; k <= 4; ++k) {
+            for (const char* source : {"a", "b", "f"}) {
+                k_hop_count query({source}, k, {});
+                uint64_t want = query.kHopCount(graph, no_prefetch);
+                check(query.kHopCount(graph, prefetched), want,
+                      string("prefetched from ") + source);
+                check(query.kHopCount(graph, prefetched_push), want,
+                      string("prefetched push from ") + source);
+            }
+            k_hop_count query({"x"}, k, {"knows", "likes"});
+            check(query.kHopCount(labeled, prefetched),
+                  query.kHopCount(labeled, no_prefetch),
+                  "labeled prefetched k=" + to_string(k));
+        }
+    }
+
+    // 点到点可达：双向扩展得到的最短跳数，超出 k 或无路径时不可达
+    auto distance = [](const hackathon::GraphStorage& g,
+                       string_view source, string_view target, int k,
+                       const vector<string>& labels = {}) {
+        KHopReach reach = kHopReach(g, source, target, k, labels);
+        return uint64_t(reach.reachable ? reach.distance : -1);
+    };
+    check(distance(graph, "a", "a", 0), 0, "reach self");
+    check(distance(graph, "a", "b", 1), 1, "reach a->b");
+    check(distance(graph, "a", "d", 3), 3, "reach a->d");
+    check(distance(graph, "a", "d", 2), uint64_t(-1), "a->d beyond k");
+    check(distance(graph, "f", "d", 10), 4, "reach f->d");
+    check(distance(graph, "d", "a", 10), uint64_t(-1), "no path d->a");
+    check(distance(graph, "a", "missing", 3), uint64_t(-1), "unknown target");
+    check(distance(labeled, "x", "z", 2), 2, "reach x->z");
+    check(distance(labeled, "x", "z", 2, {"knows"}), uint64_t(-1),
+          "reach x->z over knows only");
+    check(distance(labeled, "x", "w", 2, {"knows"}), 2,
+          "reach x->w over knows only");
+    // 与单向 BFS 的最短跳数一致
+    for (uint32_t source = 0; source < graph.NodeCount(); ++source) {
+        vector<int> hops(graph.NodeCount(), -1);
+        vector<uint32_t> queue{source};
+        hops[source] = 0;
+        for (size_t i = 0; i < queue.size(); ++i) {
+            for (uint32_t u : graph.GetOutNeighbors(queue[i])) {
+                if (hops[u] < 0) {
+                    hops[u] = hops[queue[i]] + 1;
+                    queue.push_back(u);
+                }
+            }
+        }
+        for (uint32_t target = 0; target < graph.NodeCount(); ++target) {
+            for (int k = 0; k <= 4; ++k) {
+                int want = hops[target] <= k ? hops[target] : -1;
+                check(distance(graph, graph.IdToString(source),
+                               graph.IdToString(target), k),
+                      uint64_t(want),
+                      "reach matches bfs k=" + to_string(k));
+            }
+        }
+    }
+
+    // 近似计数：寄存器多时小基数走线性计数，与精确结果一致；
+    // 草图写入图旁的容器后，重新打开的图可直接映射
+    {
+        KHopSketchOptions options;
+        options.log2m = 12;
+        options.max_hops = 8;
+        KHopSketchJob job(graph, options);
+        job.Start();
+        job.Wait();
+        auto sketches = job.Current();
+        check(sketches && sketches->Mapped() && sketches->Converged(), 1,
+              "sketches stored in sidecar");
+        for (const char* source : {"a", "b", "c", "d", "e", "f"}) {
+            for (int k = 0; k <= 6 && sketches; ++k) {
+                k_hop_count query({source}, k, {});
+                KHopEstimate estimate;
+                check(sketches->Estimate(graph, query, &estimate)
+                          ? estimate.count
+                          : uint64_t(-1),
+                      query.kHopCount(graph),
+                      string("approximate from ") + source);
+            }
+        }
+        KHopEstimate estimate;
+        check(sketches && !sketches->Estimate(
+                              graph, k_hop_count({"a"}, 2, {"knows"}),
+                              &estimate),
+              1, "labeled query is not approximated");
+
+        hackathon::GraphStorage reopened(dir + "/graph_data");
+        bool verified = true;
+        try {
+            reopened.VerifyChecksums();
+        } catch (const exception&) {
+            verified = false;
+        }
+        check(verified, 1, "graph file untouched by sketches");
+        check(KHopSketches::Open(KHopSketches::SidecarPath(reopened),
+                                 reopened, options) != nullptr,
+              1, "sketches reopened from sidecar");
+    }
+
+    // 预算放不下一个半径时降低精度，重新打开时按同样的预算接受
+    {
+        KHopSketchOptions options;
+        options.log2m = 12;
+        options.max_hops = 8;
+        options.memory_budget = size_t(graph.NodeCount()) * 768;
+        options.threads = 2;
+        KHopSketchJob job(graph, options);
+        job.Start();
+        job.Wait();
+        auto sketches = job.Current();
+        check(sketches && sketches->Mapped(), 1, "sketches within budget");
+        check(sketches ? sketches->Hops() : 0, 1, "radii limited by budget");
+        check(sketches && sketches->RelativeError() == 1.04 / sqrt(512.0), 1,
+              "log2m lowered to fit budget");
+        check(KHopSketches::Open(KHopSketches::SidecarPath(graph), graph,
+                                 options) != nullptr,
+              1, "budget-limited sketches reopened");
+        options.memory_budget = graph.NodeCount() * 8;
+        check(KHopSketches::Build(graph, options) == nullptr, 1,
+              "sketches disabled below minimum precision");
+    }
+
+    // 批量共享遍历与逐个查询结果一致，k、边标签、终点标签混合
+    vector<k_hop_count> batch;
+    for (const char* source : {"x", "y", "z", "w"}) {
+        for (int k = 0; k <= 3; ++k) {
+            batch.push_back(k_hop_count({source}, k, {}));
+            batch.push_back(k_hop_count({source}, k, {"likes"}));
+            batch.push_back(k_hop_count({source, "x"}, k, {"knows", "likes"}));
+            batch.push_back(k_hop_count({source}, k, {"follows"}));
+            batch.back().setEndLabel("Company");
+            batch.push_back(k_hop_count({source}, k, {}));
+            batch.back().setEndLabel("Company");
+        }
+    }
+    vector<uint64_t> counts = kHopCountBatch(labeled, batch);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        check(counts[i], batch[i].kHopCount(labeled, push_only),
+              "batch query " + to_string(i));
+    }
+    // 不同批大小（1、2、4 个字的掩码）交替执行，复用的缓冲不残留上一批的状态
+    for (size_t size : {200, 100, 40, 200, 100}) {
+        vector<k_hop_count> wide;
+        for (size_t i = 0; i < size; ++i) {
+            const char* sources[] = {"x", "y", "z", "w"};
+            wide.push_back(k_hop_count({sources[i % 4]}, int(i % 5), {}));
+        }
+        vector<uint64_t> wide_counts = kHopCountBatch(labeled, wide);
+        bool same = true;
+        for (size_t i = 0; i < size; ++i) {
+            same &= wide_counts[i] == wide[i].kHopCount(labeled, push_only);
+        }
+        check(same, 1, "batch of " + to_string(size) + " queries");
+    }
+
+    // 缓存：结果与直接计算一致，浅查询的遍历进度供更深的查询继续
+    KHopCache cache;
+    for (int k : {1, 3, 2, 3}) {
+        k_hop_count query({"a"}, k, {});
+        check(cache.Count(graph, query), query.kHopCount(graph),
+              "cached a k=" + to_string(k));
+    }
+    KHopCache::Stats stats = cache.GetStats();
+    check(stats.hits, 1, "cache hits");
+    check(stats.misses, 3, "cache misses");
+    check(stats.resumed, 1, "resumed from cached frontier");
+    check(stats.resumed_hops, 1, "resumed from the 1-hop frontier");
+
+    // 浅查询不覆盖更深的进度：k=2 之后 k=4 仍从 3 跳的进度继续
+    {
+        KHopCache deep_cache;
+        for (int k : {3, 2, 4}) {
+            k_hop_count query({"a"}, k, {});
+            check(deep_cache.Count(graph, query), query.kHopCount(graph),
+                  "deep cached a k=" + to_string(k));
+        }
+        KHopCache::Stats deep = deep_cache.GetStats();
+        check(deep.misses, 3, "deep cache misses");
+        check(deep.resumed, 1, "k=4 resumed from cached frontier");
+        check(deep.resumed_hops, 3, "k=4 resumed from the 3-hop frontier");
+    }
+
+    // 内存上限很小时不断淘汰，结果仍然正确
+    KHopCacheOptions tiny;
+    tiny.memory_budget = 1024;
+    tiny.shards = 2;
+    KHopCache small(tiny);
+    for (int round = 0; round < 3; ++round) {
+        for (const auto& query : batch) {
+            check(small.Count(labeled, query), query.kHopCount(labeled),
+                  "small cache");
+        }
+    }
+    check(small.GetStats().bytes <= tiny.memory_budget, 1,
+          "cache memory cap");
+    check(small.GetStats().evictions > 0, 1, "cache evictions");
+
+    filesystem::remove_all(dir);
+    cout << (failures ? "k_hop_count_test failed" : "k_hop_count_test ok")
+         << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,398 @@
+#include "graph_storage.h"
+#include <iostream>
+#include "string_dict.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+    if (!ok) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+int main() {
+    string dir = filesystem::temp_directory_path() / "graph_storage_test";
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir);
+    {
+        ofstream csv(dir + "/edges.csv");
+        csv << "startId,startLabel,edgeLabel,endId,endLabel\n"
+            << "a,Person,knows,b,Person\n"
+            << "a,Person,knows,c,Person\n"
+            << "b,Person,likes,c,Person\r\n"
+            << "d,Person,knows,a,Person";
+    }
+
+    {
+        hackathon::GraphStorage storage(dir + "/graph_data");
+        storage.BuildFromCSV(dir + "/edges.csv");
+        check(storage.NodeCount() == 4, "node count after build");
+        check(storage.GetInNeighbors(storage.StringToId("c")).size() == 2,
+              "in-neighbors after build");
+    }
+
+    // 重新打开，正反两个方向都应在构造时映射
+    hackathon::GraphStorage storage(dir + "/graph_data");
+    uint32_t a = storage.StringToId("a");
+    uint32_t b = storage.StringToId("b");
+    uint32_t c = storage.StringToId("c");
+    uint32_t d = storage.StringToId("d");
+    check(storage.NodeCount() == 4, "node count after reload");
+    check(storage.GetOutNeighbors(a) == vector<uint32_t>{b, c},
+          "out-neighbors of a");
+    check(storage.GetOutNeighbors(c).empty(), "out-neighbors of c");
+    check(storage.GetInNeighbors(a) == vector<uint32_t>{d},
+          "in-neighbors of a");
+    check(storage.GetInNeighbors(c) == vector<uint32_t>{a, b},
+          "in-neighbors of c");
+
+    vector<uint32_t> visited;
+    for (uint32_t v : storage.InNeighbors(c)) {
+        visited.push_back(v);
+    }
+    check(visited == vector<uint32_t>{a, b}, "iterate in-neighbors of c");
+    check(storage.OutNeighbors(d).DecodeInto(visited) == 1 &&
+              visited == vector<uint32_t>{a},
+          "decode out-neighbors of d into scratch");
+    check(storage.OutNeighbors(c).empty(), "empty neighbor range");
+
+    // 度数是邻居数而非压缩后的字节数，边数随格式保存
+    check(storage.OutDegree(a) == 2 && storage.InDegree(c) == 2 &&
+              storage.OutDegree(c) == 0 && storage.InDegree(d) == 0,
+          "degrees count neighbors");
+    check(storage.EdgeCount() == 4, "edge count after reload");
+
+    check(storage.StringToId("missing") == static_cast<uint32_t>(-1),
+          "unknown id");
+    check(storage.IdToString(a) == "a" && storage.IdToString(d) == "d",
+          "id to string");
+
+    // 完美哈希字典：所有键唯一定位，不存在的键返回 kNotFound
+    {
+        const uint32_t n = 100000;
+        hackathon::StringDictionaryBuilder builder(dir + "/dict_strings.bin",
+                                                   dir + "/dict_offsets.bin");
+        for (uint32_t i = 0; i < n; ++i) {
+            builder.Add("node" + to_string(i));
+        }
+        builder.Finish(dir + "/dict_index.bin", 4);
+
+        auto read = [](const string& path) {
+            ifstream in(path, ios::binary);
+            return vector<uint8_t>(istreambuf_iterator<char>(in), {});
+        };
+        auto strings = read(dir + "/dict_strings.bin");
+        auto offsets = read(dir + "/dict_offsets.bin");
+        auto index = read(dir + "/dict_index.bin");
+        hackathon::StringDictionary dict(strings.data(), strings.size(),
+                                         offsets.data(), offsets.size(),
+                                         index.data(), index.size());
+        bool ok = dict.Size() == n;
+        for (uint32_t i = 0; i < n && ok; ++i) {
+            string key = "node" + to_string(i);
+            ok = dict.Find(key) == i && dict.Get(i) == key &&
+                 dict.Find(key + "x") == hackathon::StringDictionary::kNotFound;
+        }
+        check(ok, "perfect hash dictionary lookups");
+    }
+
+    // 标签字典与按边标签分段：a 的出边只有 knows，b 的出边只有 likes
+    uint16_t knows = storage.EdgeLabelId("knows");
+    uint16_t likes = storage.EdgeLabelId("likes");
+    check(knows != hackathon::GraphStorage::kNoLabel &&
+              likes != hackathon::GraphStorage::kNoLabel && knows != likes,
+          "edge label ids");
+    check(storage.EdgeLabelId("missing") == hackathon::GraphStorage::kNoLabel,
+          "unknown edge label");
+    check(storage.HasLabels() &&
+              storage.VertexLabel(a) == storage.VertexLabelId("Person"),
+          "vertex label column");
+    auto segments = storage.InSegments(c);
+    check(segments.size() == 2 && segments[0].label == knows &&
+              segments[0].count == 1 && segments[1].label == likes &&
+              segments[1].count == 1,
+          "in-segments of c");
+    visited.clear();
+    if (segments.size() == 2) {
+        storage.InNeighbors(c).ForEachInSegment(
+            segments[1], 0, segments[1].count, [&](uint32_t v) {
+                visited.push_back(v);
+                return true;
+            });
+    }
+    check(visited == vector<uint32_t>{b}, "decode likes segment of c");
+
+    // 两种邻居表编码应解码出相同的结果
+    {
+        hackathon::BuildOptions options;
+        options.codec = hackathon::NeighborCodec::kVarint;
+        hackathon::GraphStorage varint(dir + "/graph_varint");
+        varint.BuildFromCSV(dir + "/edges.csv", options);
+    }
+    hackathon::GraphStorage varint(dir + "/graph_varint");
+    check(varint.Codec() == hackathon::NeighborCodec::kVarint,
+          "codec recorded in format header");
+    for (uint32_t v = 0; v < storage.NodeCount(); ++v) {
+        check(varint.GetOutNeighbors(v) == storage.GetOutNeighbors(v) &&
+                  varint.GetInNeighbors(v) == storage.GetInNeighbors(v),
+              "codecs agree on vertex " + to_string(v));
+    }
+
+    // 重编号只改变 ID，按字符串比较邻接关系应与原图一致
+    auto names = [](const hackathon::GraphStorage& g, vector<uint32_t> ids) {
+        vector<string> result;
+        for (uint32_t id : ids) {
+            result.emplace_back(g.IdToString(id));
+        }
+        sort(result.begin(), result.end());
+        return result;
+    };
+    auto same_graph = [&](const hackathon::GraphStorage& other) {
+        bool same = other.NodeCount() == storage.NodeCount() &&
+                    other.EdgeCount() == storage.EdgeCount();
+        for (uint32_t v = 0; v < storage.NodeCount() && same; ++v) {
+            uint32_t w = other.StringToId(storage.IdToString(v));
+            same = w < other.NodeCount() &&
+                   other.VertexLabel(w) == storage.VertexLabel(v) &&
+                   names(other, other.GetOutNeighbors(w)) ==
+                       names(storage, storage.GetOutNeighbors(v)) &&
+                   names(other, other.GetInNeighbors(w)) ==
+                       names(storage, storage.GetInNeighbors(v));
+        }
+        return same;
+    };
+    // 高度数顶点：delta 依次取 1~4 字节，长表走 SIMD 按组解码，末尾走标量
+    {
+        static const uint32_t kDeltas[] = {1, 300, 70000, 20000000, 7};
+        vector<uint32_t> hub;
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < 60; ++i) {
+            value += kDeltas[(i * 3 + i / 5) % 5];
+            hub.push_back(value);
+        }
+        for (auto codec : {hackathon::NeighborCodec::kStreamVByte,
+                           hackathon::NeighborCodec::kVarint}) {
+            vector<uint8_t> encoded;
+            hackathon::EncodeNeighbors(hub, codec, encoded);
+            hackathon::NeighborRange range(encoded.data(), encoded.size(),
+                                           codec);
+            vector<uint32_t> decoded;
+            range.DecodeInto(decoded);
+            vector<uint32_t> iterated(range.begin(), range.end());
+            vector<uint32_t> tail;
+            range.ForEachInRange(37, hub.size(),
+                                 [&](uint32_t v) { tail.push_back(v); });
+            check(range.size() == hub.size() && decoded == hub &&
+                      iterated == hub &&
+                      tail == vector<uint32_t>(hub.begin() + 37, hub.end()),
+                  "decode hub list with codec " + to_string(int(codec)));
+        }
+    }
+
+    // 几十条出边的顶点经过构建、SIMD 解码后与输入一致
+    {
+        ofstream csv(dir + "/hub.csv");
+        csv << "startId,startLabel,edgeLabel,endId,endLabel\n";
+        for (int i = 0; i < 48; ++i) {
+            csv << "hub,Person,knows,n" << i << ",Person\n";
+        }
+    }
+    {
+        hackathon::GraphStorage hub(dir + "/graph_hub");
+        hub.BuildFromCSV(dir + "/hub.csv");
+        vector<string> want;
+        for (int i = 0; i < 48; ++i) {
+            want.push_back("n" + to_string(i));
+        }
+        sort(want.begin(), want.end());
+        check(names(hub, hub.GetOutNeighbors(hub.StringToId("hub"))) == want,
+              "hub out-neighbors");
+    }
+
+    // 同一顶点在不同行给出不同标签时拒绝构建，而不是随机保留一个
+    {
+        ofstream csv(dir + "/conflict.csv");
+        csv << "startId,startLabel,edgeLabel,endId,endLabel\n";
+        csv << "x,Person,knows,y,Person\n";
+        csv << "y,Company,knows,z,Person\n";
+    }
+    {
+        hackathon::GraphStorage conflict(dir + "/graph_conflict");
+        bool rejected = false;
+        try {
+            conflict.BuildFromCSV(dir + "/conflict.csv");
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        check(rejected, "conflicting vertex labels rejected");
+    }
+
+    // 没有结尾换行的最后一行终点标签为空时也要读入
+    {
+        ofstream csv(dir + "/empty_label.csv");
+        csv << "startId,startLabel,edgeLabel,endId,endLabel\n"
+            << "x,Person,knows,y,Person\n"
+            << "y,Person,knows,z,";
+    }
+    {
+        hackathon::GraphStorage tail(dir + "/graph_empty_label");
+        tail.BuildFromCSV(dir + "/empty_label.csv");
+        uint32_t z = tail.StringToId("z");
+        check(tail.EdgeCount() == 2 && z != static_cast<uint32_t>(-1) &&
+                  tail.GetInNeighbors(z) ==
+                      vector<uint32_t>{tail.StringToId("y")},
+              "last row with empty end label and no newline");
+    }
+
+    // 同一标签的邻居超过单段上限时切成多段，各段从自己的恢复点解码
+    {
+        ofstream csv(dir + "/big_hub.csv");
+        csv << "startId,startLabel,edgeLabel,endId,endLabel\n";
+        for (int i = 0; i < 2500; ++i) {
+            csv << "hub,Person,knows,n" << i * 7 << ",Person\n";
+        }
+        for (int i = 0; i < 3; ++i) {
+            csv << "hub,Person,likes,m" << i << ",Person\n";
+        }
+    }
+    {
+        hackathon::GraphStorage hub(dir + "/graph_big_hub");
+        hub.BuildFromCSV(dir + "/big_hub.csv");
+        uint32_t v = hub.StringToId("hub");
+        auto segments = hub.OutSegments(v);
+        bool bounded = segments.size() == 4;
+        vector<uint32_t> expected;
+        hub.OutNeighbors(v).DecodeInto(expected);
+        vector<uint32_t> joined;
+        for (const auto& segment : segments) {
+            bounded &= segment.count <= hackathon::kMaxSegmentLength;
+            hub.OutNeighbors(v).ForEachInSegment(
+                segment, 0, segment.count, [&](uint32_t u) {
+                    joined.push_back(u);
+                    return true;
+                });
+        }
+        check(bounded && expected.size() == 2503 && joined == expected,
+              "long label segments are split");
+    }
+
+    for (auto order : {hackathon::VertexOrder::kDegree,
+                       hackathon::VertexOrder::kRcm,
+                       hackathon::VertexOrder::kGorder}) {
+        string path = dir + "/graph_order" + to_string(int(order));
+        {
+            hackathon::BuildOptions options;
+            options.vertex_order = order;
+            hackathon::GraphStorage reordered(path);
+            reordered.BuildFromCSV(dir + "/edges.csv", options);
+        }
+        hackathon::GraphStorage reordered(path);
+        check(reordered.Order() == order && same_graph(reordered),
+              "vertex order " + to_string(int(order)));
+    }
+    {
+        // a 的出入度之和最大，按度数排序后编号为 0
+        hackathon::GraphStorage reordered(dir + "/graph_order1");
+        check(reordered.StringToId("a") == 0, "degree order puts hub first");
+    }
+
+    // 节点表预算极小时所有分区都溢写，待解析的边在第二步补全，结果应一致
+    {
+        hackathon::BuildOptions options;
+        options.dictionary_memory_budget = 1;
+        hackathon::GraphStorage spilled(dir + "/graph_spilled");
+        spilled.BuildFromCSV(dir + "/edges.csv", options);
+        check(same_graph(spilled), "build with spilled node partitions");
+    }
+
+    // 写缓冲取最小值时 CSR 分多次写出，结果应一致
+    {
+        hackathon::BuildOptions options;
+        options.csr_write_buffer = 0;
+        hackathon::GraphStorage streamed(dir + "/graph_streamed");
+        streamed.BuildFromCSV(dir + "/edges.csv", options);
+        check(same_graph(streamed), "build with minimal CSR write buffer");
+    }
+
+    // 各种映射策略只影响常驻方式，查询结果不变
+    {
+        hackathon::LoadOptions options;
+        options.prefault = hackathon::Prefault::kParallel;
+        options.advise = true;
+        options.lock_offsets = true;
+        hackathon::GraphStorage warmed(dir + "/graph_data", options);
+        check(same_graph(warmed) && warmed.Warmup().prefaulted_bytes > 0,
+              "parallel prefault");
+
+        options = {};
+        options.prefault = hackathon::Prefault::kPopulate;
+        options.copy_to_huge_pages = true;
+        hackathon::GraphStorage copied(dir + "/graph_data", options);
+        check(same_graph(copied) && copied.Warmup().copied_bytes > 0,
+              "copy hot sections to huge pages");
+
+        // 先按默认策略打开再重建时，只在重建完成后预热一次
+        hackathon::GraphStorage rebuilt(dir + "/graph_rebuilt");
+        options = {};
+        options.prefault = hackathon::Prefault::kParallel;
+        rebuilt.SetLoadOptions(options);
+        rebuilt.BuildFromCSV(dir + "/edges.csv");
+        check(same_graph(rebuilt) && rebuilt.Warmup().prefaulted_bytes > 0,
+              "prefault after rebuild");
+    }
+
+    // 构建结果打包为单文件容器；截断在打开时发现，数据损坏由校验和发现
+    {
+        string graph = dir + "/graph_data/graph.hkg";
+        check(filesystem::exists(graph) &&
+                  !filesystem::exists(dir + "/graph_data/forward_offsets.bin"),
+              "build packs a single graph file");
+        bool verified = true;
+        try {
+            storage.VerifyChecksums();
+        } catch (const exception&) {
+            verified = false;
+        }
+        check(verified, "checksums of a fresh build");
+
+        auto opens = [](const string& path) {
+            try {
+                hackathon::GraphStorage g(path);
+                return true;
+            } catch (const exception&) {
+                return false;
+            }
+        };
+        filesystem::create_directories(dir + "/graph_truncated");
+        filesystem::copy_file(graph, dir + "/graph_truncated/graph.hkg");
+        filesystem::resize_file(dir + "/graph_truncated/graph.hkg",
+                                filesystem::file_size(graph) - 1);
+        check(!opens(dir + "/graph_truncated"), "truncated graph file rejected");
+
+        filesystem::create_directories(dir + "/graph_corrupt");
+        filesystem::copy_file(graph, dir + "/graph_corrupt/graph.hkg");
+        {
+            // 第一段从 2 MB 处开始
+            fstream file(dir + "/graph_corrupt/graph.hkg",
+                         ios::in | ios::out | ios::binary);
+            file.seekp(hackathon::GraphFile::kAlignment + 4);
+            file.put(char(0x7F));
+        }
+        hackathon::GraphStorage corrupt(dir + "/graph_corrupt");
+        bool detected = false;
+        try {
+            corrupt.VerifyChecksums();
+        } catch (const exception&) {
+            detected = true;
+        }
+        check(detected, "corrupt section detected by checksum");
+    }
+
+    filesystem::remove_all(dir);
+    cout << (failures ? "graph_storage_test failed" : "graph_storage_test ok")
+         << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+// 邻居表解码基准：同一条长邻居表分别按 varint 和 StreamVByte 编码，
+// 比较 DecodeInto 的吞吐。用法：neighbor_codec_bench [邻居数] [轮数]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "neighbor_codec.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 50;
+
+    // delta 大多为 1~2 字节，少量 3~4 字节，接近重编号后的社交图
+    mt19937 rng(42);
+    vector<uint32_t> neighbors(count);
+    uint32_t value = 0;
+    for (auto& v : neighbors) {
+        uint32_t r = rng() % 100;
+        value += r < 70   ? 1 + rng() % 255
+                 : r < 97 ? rng() % 65536
+                          : rng() % 1000000;
+        v = value;
+    }
+
+    double baseline = 0;
+    for (auto codec : {hackathon::NeighborCodec::kVarint,
+                       hackathon::NeighborCodec::kStreamVByte}) {
+        vector<uint8_t> encoded;
+        hackathon::EncodeNeighbors(neighbors, codec, encoded);
+        hackathon::NeighborRange range(encoded.data(), encoded.size(), codec);
+        vector<uint32_t> out;
+        range.DecodeInto(out);
+        if (out != neighbors) {
+            cerr << "decode mismatch" << endl;
+            return 1;
+        }
+        auto start = chrono::steady_clock::now();
+        uint64_t checksum = 0;
+        for (int r = 0; r < rounds; ++r) {
+            range.DecodeInto(out);
+            checksum += out.back();
+        }
+        double seconds =
+            chrono::duration<double>(chrono::steady_clock::now() - start)
+                .count();
+        double ns = seconds * 1e9 / (double(count) * rounds);
+        if (codec == hackathon::NeighborCodec::kVarint)
+            baseline = ns;
+        cout << (codec == hackathon::NeighborCodec::kVarint ? "varint     "
+                                                            : "streamvbyte")
+             << "  " << encoded.size() << " bytes  " << ns << " ns/neighbor  "
+             << baseline / ns << "x  (checksum " << checksum << ")" << endl;
+    }
+    return 0;
+}